@@ -0,0 +1,165 @@
+/*
+ gui-arena.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "levels.h"
+
+#include "printtext.h"
+
+#include "gui-arena.h"
+
+#include <stdarg.h>
+
+#define ARENA_ALIGN(size) (((size) + 7) & ~7)
+/* don't keep more than this around after an unusually long line */
+#define ARENA_MAX_SIZE (64*1024)
+
+struct _GuiArena {
+	char *data;
+	int size, used;
+
+	/* allocations that didn't fit, freed at reset */
+	GSList *overflow;
+	int overflow_size;
+};
+
+static struct {
+	unsigned long allocs, bytes, resets, mallocs;
+} arena_stats;
+
+GuiArena *gui_arena_new(int size)
+{
+	GuiArena *arena;
+
+	arena = g_new0(GuiArena, 1);
+	arena->size = ARENA_ALIGN(size);
+	arena->data = g_malloc(arena->size);
+	arena_stats.mallocs++;
+	return arena;
+}
+
+void gui_arena_destroy(GuiArena *arena)
+{
+	gui_arena_reset(arena);
+	g_free(arena->data);
+	g_free(arena);
+}
+
+void *gui_arena_alloc(GuiArena *arena, int size)
+{
+	void *mem;
+
+	size = ARENA_ALIGN(size);
+	arena_stats.allocs++;
+	arena_stats.bytes += size;
+
+	if (arena->used + size <= arena->size) {
+		mem = arena->data + arena->used;
+		arena->used += size;
+		return mem;
+	}
+
+	mem = g_malloc(size);
+	arena->overflow = g_slist_prepend(arena->overflow, mem);
+	arena->overflow_size += size;
+	arena_stats.mallocs++;
+	return mem;
+}
+
+char *gui_arena_strndup(GuiArena *arena, const char *str, int len)
+{
+	char *ret;
+
+	ret = gui_arena_alloc(arena, len+1);
+	memcpy(ret, str, len);
+	ret[len] = '\0';
+	return ret;
+}
+
+char *gui_arena_strconcat(GuiArena *arena, const char *str, ...)
+{
+	va_list va;
+	const char *p;
+	char *ret, *dest;
+	int len;
+
+	len = 0;
+	va_start(va, str);
+	for (p = str; p != NULL; p = va_arg(va, const char *))
+		len += strlen(p);
+	va_end(va);
+
+	dest = ret = gui_arena_alloc(arena, len+1);
+	va_start(va, str);
+	for (p = str; p != NULL; p = va_arg(va, const char *)) {
+		len = strlen(p);
+		memcpy(dest, p, len);
+		dest += len;
+	}
+	va_end(va);
+	*dest = '\0';
+	return ret;
+}
+
+void gui_arena_reset(GuiArena *arena)
+{
+	GSList *tmp;
+
+	arena_stats.resets++;
+	if (arena->overflow != NULL) {
+		for (tmp = arena->overflow; tmp != NULL; tmp = tmp->next)
+			g_free(tmp->data);
+		g_slist_free(arena->overflow);
+		arena->overflow = NULL;
+
+		/* grow so that the next line like this fits */
+		arena->size = ARENA_ALIGN(arena->used + arena->overflow_size);
+		if (arena->size > ARENA_MAX_SIZE)
+			arena->size = ARENA_MAX_SIZE;
+		arena->overflow_size = 0;
+		g_free(arena->data);
+		arena->data = g_malloc(arena->size);
+		arena_stats.mallocs++;
+	}
+	arena->used = 0;
+}
+
+static void sig_gui_stats(Window *window)
+{
+	printtext_window(window, MSGLEVEL_CLIENTNOTICE,
+			 "Line arenas: %lu allocations (%lu bytes), "
+			 "%lu resets, %lu mallocs",
+			 arena_stats.allocs, arena_stats.bytes,
+			 arena_stats.resets, arena_stats.mallocs);
+}
+
+void gui_arenas_init(void)
+{
+	memset(&arena_stats, 0, sizeof(arena_stats));
+
+	signal_add("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
+
+void gui_arenas_deinit(void)
+{
+	signal_remove("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
@@ -0,0 +1,22 @@
+#ifndef __GUI_ARENA_H
+#define __GUI_ARENA_H
+
+/* Scratch memory for strings that are only needed while a line is
+   being printed. Everything is freed at once with gui_arena_reset(),
+   and the arena grows to fit the largest line seen so far. */
+typedef struct _GuiArena GuiArena;
+
+GuiArena *gui_arena_new(int size);
+void gui_arena_destroy(GuiArena *arena);
+
+void *gui_arena_alloc(GuiArena *arena, int size);
+char *gui_arena_strndup(GuiArena *arena, const char *str, int len);
+/* NULL terminated list of strings */
+char *gui_arena_strconcat(GuiArena *arena, const char *str, ...);
+
+void gui_arena_reset(GuiArena *arena);
+
+void gui_arenas_init(void);
+void gui_arenas_deinit(void);
+
+#endif
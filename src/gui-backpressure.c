@@ -0,0 +1,298 @@
+/*
+ gui-backpressure.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+#include "servers.h"
+#include "levels.h"
+
+#include "printtext.h"
+
+#include "irc.h"
+#include "netsplit.h"
+
+#include "gui-window.h"
+#include "gui-window-message.h"
+#include "gui-backpressure.h"
+
+/* how often the main loop latency is measured */
+#define CHECK_INTERVAL 100
+/* print the summaries at least this often while overloaded */
+#define SUMMARY_FLUSH_TIME 5000
+/* stay summarizing until the latency has been low for this long */
+#define CALM_TIME 1000
+
+#define SUMMARY_LEVELS \
+	(MSGLEVEL_JOINS | MSGLEVEL_PARTS | MSGLEVEL_QUITS | MSGLEVEL_NICKS)
+
+typedef struct {
+	Window *window;
+	int joins, parts, quits, nicks;
+	char *split; /* "a.b c.d" if all the quits were from this split */
+	unsigned int mixed_quits:1;
+} Summary;
+
+static GHashTable *summaries; /* Window => Summary */
+
+static int check_tag;
+static GTimeVal last_check, last_flush, last_busy;
+static int latency; /* msecs, smoothed */
+static int lines; /* lines printed since last check */
+static Window *dropping; /* window whose line is being summarized */
+
+static struct {
+	unsigned long summarized, summaries;
+	int max_latency;
+} stats;
+
+/* Returns TRUE if window's events should be summarized now. Visible
+   windows have the stricter latency limit, since their text needs to
+   be laid out right away. */
+static int window_is_overloaded(Window *window)
+{
+	int limit;
+
+	limit = gui_window_is_visible(window) ?
+		settings_get_int("gui_backpressure_latency_visible") :
+		settings_get_int("gui_backpressure_latency_hidden");
+	return limit > 0 && latency >= limit;
+}
+
+static Summary *summary_get(Window *window)
+{
+	Summary *rec;
+
+	rec = g_hash_table_lookup(summaries, window);
+	if (rec == NULL) {
+		rec = g_new0(Summary, 1);
+		rec->window = window;
+		g_hash_table_insert(summaries, window, rec);
+	}
+	return rec;
+}
+
+static void summary_print(Window *window, Summary *rec)
+{
+	if (rec->joins > 0) {
+		printtext_window(window, MSGLEVEL_JOINS,
+				 "%d users joined", rec->joins);
+	}
+	if (rec->parts > 0) {
+		printtext_window(window, MSGLEVEL_PARTS,
+				 "%d users left", rec->parts);
+	}
+	if (rec->quits > 0 && rec->split != NULL && !rec->mixed_quits) {
+		printtext_window(window, MSGLEVEL_QUITS,
+				 "%d users quit (netsplit %s)",
+				 rec->quits, rec->split);
+	} else if (rec->quits > 0) {
+		printtext_window(window, MSGLEVEL_QUITS,
+				 "%d users quit", rec->quits);
+	}
+	if (rec->nicks > 0) {
+		printtext_window(window, MSGLEVEL_NICKS,
+				 "%d nick changes", rec->nicks);
+	}
+	stats.summaries++;
+}
+
+static int summary_flush(Window *window, Summary *rec)
+{
+	summary_print(window, rec);
+	g_free(rec->split);
+	g_free(rec);
+	return TRUE;
+}
+
+static void summaries_flush(void)
+{
+	g_hash_table_foreach_remove(summaries, (GHRFunc) summary_flush, NULL);
+}
+
+static long timeval_diff_msecs(const GTimeVal *tv1, const GTimeVal *tv2)
+{
+	return (tv2->tv_sec - tv1->tv_sec) * 1000 +
+		(tv2->tv_usec - tv1->tv_usec) / 1000;
+}
+
+static gboolean backpressure_check(void)
+{
+	GTimeVal now;
+	int late;
+
+	g_get_current_time(&now);
+
+	/* how late the timeout was, ie. how long the main loop was
+	   busy with something else */
+	late = timeval_diff_msecs(&last_check, &now) - CHECK_INTERVAL;
+	if (late < 0)
+		late = 0;
+	latency = (latency*3 + late) / 4;
+	if (latency > stats.max_latency)
+		stats.max_latency = latency;
+
+	/* lots of printing will make us late soon anyway */
+	if (lines > settings_get_int("gui_backpressure_lines") &&
+	    settings_get_int("gui_backpressure_lines") > 0)
+		latency = MAX(latency, settings_get_int("gui_backpressure_latency_visible"));
+	lines = 0;
+	last_check = now;
+
+	if (latency >= settings_get_int("gui_backpressure_latency_visible") / 2)
+		last_busy = now;
+
+	if (g_hash_table_size(summaries) == 0)
+		last_flush = now;
+	else if (timeval_diff_msecs(&last_busy, &now) >= CALM_TIME ||
+		 timeval_diff_msecs(&last_flush, &now) >= SUMMARY_FLUSH_TIME) {
+		summaries_flush();
+		last_flush = now;
+	}
+
+	return TRUE;
+}
+
+static void summary_add_quit(Summary *rec, GuiMessage *message)
+{
+	const char *split;
+
+	split = message != NULL && message->reason != NULL &&
+		quitmsg_is_split(message->reason) ? message->reason : NULL;
+
+	if (rec->quits++ == 0)
+		rec->split = g_strdup(split);
+	else if (split == NULL || rec->split == NULL ||
+		 strcmp(rec->split, split) != 0)
+		rec->mixed_quits = TRUE;
+}
+
+/* The lines are dropped here rather than at the message signals, so
+   logging and scripts still see every event. */
+static void sig_gui_print_text(Window *window, void *fgcolor,
+			       void *bgcolor, void *pflags,
+			       const char *str, TEXT_DEST_REC *dest)
+{
+	GuiMessage *message;
+	Summary *rec;
+
+	if (dropping == window) {
+		/* rest of the line */
+		signal_stop();
+		return;
+	}
+
+	/* summaries themselves are printed without a server */
+	if (dest == NULL || dest->server == NULL ||
+	    (dest->level & SUMMARY_LEVELS) == 0 ||
+	    (dest->level & MSGLEVEL_HILIGHT) != 0 ||
+	    !window_is_overloaded(window))
+		return;
+
+	message = gui_window_message_get(dest);
+	if (message != NULL && dest->server->nick != NULL &&
+	    g_strcasecmp(message->nick, dest->server->nick) == 0)
+		return;
+
+	rec = summary_get(window);
+	if (dest->level & MSGLEVEL_JOINS)
+		rec->joins++;
+	else if (dest->level & MSGLEVEL_PARTS)
+		rec->parts++;
+	else if (dest->level & MSGLEVEL_QUITS)
+		summary_add_quit(rec, message);
+	else
+		rec->nicks++;
+
+	dropping = window;
+	stats.summarized++;
+	signal_stop();
+}
+
+static void sig_gui_print_text_finished(Window *window)
+{
+	if (dropping != window) {
+		lines++;
+		return;
+	}
+
+	/* nothing of the line was printed */
+	dropping = NULL;
+	gui_window_message_finished();
+	signal_stop();
+}
+
+static void sig_window_destroyed(Window *window)
+{
+	Summary *rec;
+
+	if (dropping == window)
+		dropping = NULL;
+
+	rec = g_hash_table_lookup(summaries, window);
+	if (rec != NULL) {
+		g_hash_table_remove(summaries, window);
+		g_free(rec->split);
+		g_free(rec);
+	}
+}
+
+static void sig_gui_stats(Window *window)
+{
+	printtext_window(window, MSGLEVEL_CLIENTNOTICE,
+			 "Backpressure: latency %d ms (max %d), %lu lines "
+			 "summarized in %lu summaries", latency,
+			 stats.max_latency, stats.summarized, stats.summaries);
+}
+
+void gui_backpressure_init(void)
+{
+	summaries = g_hash_table_new((GHashFunc) g_direct_hash,
+				     (GCompareFunc) g_direct_equal);
+	latency = lines = 0;
+	dropping = NULL;
+	g_get_current_time(&last_check);
+	last_flush = last_busy = last_check;
+
+	settings_add_int("lookandfeel", "gui_backpressure_latency_visible", 100);
+	settings_add_int("lookandfeel", "gui_backpressure_latency_hidden", 300);
+	settings_add_int("lookandfeel", "gui_backpressure_lines", 50);
+
+	check_tag = g_timeout_add(CHECK_INTERVAL,
+				  (GSourceFunc) backpressure_check, NULL);
+
+	signal_add_first("gui print text", (SIGNAL_FUNC) sig_gui_print_text);
+	signal_add_first("gui print text finished", (SIGNAL_FUNC) sig_gui_print_text_finished);
+	signal_add("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_add("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
+
+void gui_backpressure_deinit(void)
+{
+	g_source_remove(check_tag);
+	summaries_flush();
+	g_hash_table_destroy(summaries);
+
+	signal_remove("gui print text", (SIGNAL_FUNC) sig_gui_print_text);
+	signal_remove("gui print text finished", (SIGNAL_FUNC) sig_gui_print_text_finished);
+	signal_remove("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_remove("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
@@ -0,0 +1,10 @@
+#ifndef __GUI_BACKPRESSURE_H
+#define __GUI_BACKPRESSURE_H
+
+/* When the main loop falls behind, joins, parts, quits and nick changes
+   aren't printed one by one, but summarized per window once things
+   calm down again. */
+void gui_backpressure_init(void);
+void gui_backpressure_deinit(void);
+
+#endif
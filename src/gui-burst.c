@@ -0,0 +1,279 @@
+/*
+ gui-burst.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+#include "servers.h"
+#include "levels.h"
+
+#include "printtext.h"
+
+#include "gui-burst.h"
+
+/* how often to check if the joins have settled */
+#define BURST_CHECK_INTERVAL 200
+/* end the burst after this many msecs even if the server keeps us busy */
+#define BURST_MAX_TIME 10000
+
+typedef struct {
+	GuiBurstFunc func;
+	void *data;
+} BurstRefresh;
+
+typedef struct {
+	Server *server;
+	GTimeVal start, last_activity;
+} ServerBurst;
+
+static int freeze_count;
+static GSList *refreshes; /* BurstRefresh, in the order they were queued */
+static GHashTable *refresh_set; /* BurstRefresh => BurstRefresh */
+
+static GSList *server_bursts;
+static int check_tag;
+
+static struct {
+	unsigned long bursts, deferred, merged;
+} burst_stats;
+
+static guint refresh_hash(const BurstRefresh *rec)
+{
+	return GPOINTER_TO_UINT(rec->func) ^ GPOINTER_TO_UINT(rec->data);
+}
+
+static gint refresh_equal(const BurstRefresh *rec1, const BurstRefresh *rec2)
+{
+	return rec1->func == rec2->func && rec1->data == rec2->data;
+}
+
+void gui_burst_freeze(void)
+{
+	freeze_count++;
+}
+
+void gui_burst_thaw(void)
+{
+	GSList *list, *tmp;
+
+	g_return_if_fail(freeze_count > 0);
+
+	if (--freeze_count > 0)
+		return;
+
+	/* refreshes may queue more refreshes, but those are run
+	   immediately since we're not frozen anymore */
+	list = g_slist_reverse(refreshes);
+	refreshes = NULL;
+	g_hash_table_destroy(refresh_set);
+	refresh_set = g_hash_table_new((GHashFunc) refresh_hash,
+				       (GCompareFunc) refresh_equal);
+
+	for (tmp = list; tmp != NULL; tmp = tmp->next) {
+		BurstRefresh *rec = tmp->data;
+
+		rec->func(rec->data);
+		g_free(rec);
+	}
+	g_slist_free(list);
+}
+
+int gui_burst_is_frozen(void)
+{
+	return freeze_count > 0;
+}
+
+int gui_burst_defer(GuiBurstFunc func, void *data)
+{
+	BurstRefresh *rec, lookup;
+
+	if (freeze_count == 0)
+		return FALSE;
+
+	lookup.func = func;
+	lookup.data = data;
+	if (g_hash_table_lookup(refresh_set, &lookup) != NULL) {
+		burst_stats.merged++;
+		return TRUE;
+	}
+
+	rec = g_new(BurstRefresh, 1);
+	rec->func = func;
+	rec->data = data;
+	g_hash_table_insert(refresh_set, rec, rec);
+	refreshes = g_slist_prepend(refreshes, rec);
+
+	burst_stats.deferred++;
+	return TRUE;
+}
+
+void gui_burst_cancel(void *data)
+{
+	GSList *tmp, *next;
+
+	for (tmp = refreshes; tmp != NULL; tmp = next) {
+		BurstRefresh *rec = tmp->data;
+
+		next = tmp->next;
+		if (rec->data == data) {
+			g_hash_table_remove(refresh_set, rec);
+			refreshes = g_slist_remove(refreshes, rec);
+			g_free(rec);
+		}
+	}
+}
+
+static long timeval_diff_msecs(const GTimeVal *tv1, const GTimeVal *tv2)
+{
+	return (tv2->tv_sec - tv1->tv_sec) * 1000 +
+		(tv2->tv_usec - tv1->tv_usec) / 1000;
+}
+
+static void server_burst_end(ServerBurst *rec)
+{
+	server_bursts = g_slist_remove(server_bursts, rec);
+	server_unref(rec->server);
+	g_free(rec);
+
+	gui_burst_thaw();
+}
+
+static gboolean burst_check(void)
+{
+	GSList *tmp, *next;
+	GTimeVal now;
+	long settle;
+
+	g_get_current_time(&now);
+	settle = settings_get_int("gui_burst_settle_time");
+
+	for (tmp = server_bursts; tmp != NULL; tmp = next) {
+		ServerBurst *rec = tmp->data;
+
+		next = tmp->next;
+		if (timeval_diff_msecs(&rec->last_activity, &now) >= settle ||
+		    timeval_diff_msecs(&rec->start, &now) >= BURST_MAX_TIME)
+			server_burst_end(rec);
+	}
+
+	if (server_bursts != NULL)
+		return TRUE;
+
+	check_tag = -1;
+	return FALSE;
+}
+
+static void sig_server_connected(Server *server)
+{
+	ServerBurst *rec;
+
+	if (settings_get_int("gui_burst_settle_time") <= 0)
+		return;
+
+	rec = g_new0(ServerBurst, 1);
+	rec->server = server;
+	server_ref(server);
+	g_get_current_time(&rec->start);
+	rec->last_activity = rec->start;
+	server_bursts = g_slist_prepend(server_bursts, rec);
+
+	burst_stats.bursts++;
+	gui_burst_freeze();
+
+	if (check_tag == -1) {
+		check_tag = g_timeout_add(BURST_CHECK_INTERVAL,
+					  (GSourceFunc) burst_check, NULL);
+	}
+}
+
+static void sig_server_disconnected(Server *server)
+{
+	GSList *tmp;
+
+	for (tmp = server_bursts; tmp != NULL; tmp = tmp->next) {
+		ServerBurst *rec = tmp->data;
+
+		if (rec->server == server) {
+			server_burst_end(rec);
+			break;
+		}
+	}
+}
+
+/* numeric replies (motd, names, topics..) and joins keep the burst
+   going, normal chatting in the joined channels doesn't */
+static void sig_server_event(Server *server, const char *data)
+{
+	GSList *tmp;
+
+	if (server_bursts == NULL)
+		return;
+
+	if (!i_isdigit(*data) && g_ascii_strncasecmp(data, "JOIN ", 5) != 0)
+		return;
+
+	for (tmp = server_bursts; tmp != NULL; tmp = tmp->next) {
+		ServerBurst *rec = tmp->data;
+
+		if (rec->server == server) {
+			g_get_current_time(&rec->last_activity);
+			break;
+		}
+	}
+}
+
+static void sig_gui_stats(Window *window)
+{
+	printtext_window(window, MSGLEVEL_CLIENTNOTICE,
+			 "Bursts: %lu, %lu refreshes deferred, %lu merged",
+			 burst_stats.bursts, burst_stats.deferred,
+			 burst_stats.merged);
+}
+
+void gui_bursts_init(void)
+{
+	freeze_count = 0;
+	refreshes = NULL;
+	refresh_set = g_hash_table_new((GHashFunc) refresh_hash,
+				       (GCompareFunc) refresh_equal);
+	server_bursts = NULL;
+	check_tag = -1;
+
+	settings_add_int("lookandfeel", "gui_burst_settle_time", 1000);
+
+	signal_add("server connected", (SIGNAL_FUNC) sig_server_connected);
+	signal_add("server disconnected", (SIGNAL_FUNC) sig_server_disconnected);
+	signal_add("server event", (SIGNAL_FUNC) sig_server_event);
+	signal_add("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
+
+void gui_bursts_deinit(void)
+{
+	while (server_bursts != NULL)
+		server_burst_end(server_bursts->data);
+	if (check_tag != -1)
+		g_source_remove(check_tag);
+	g_hash_table_destroy(refresh_set);
+
+	signal_remove("server connected", (SIGNAL_FUNC) sig_server_connected);
+	signal_remove("server disconnected", (SIGNAL_FUNC) sig_server_disconnected);
+	signal_remove("server event", (SIGNAL_FUNC) sig_server_event);
+	signal_remove("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
@@ -0,0 +1,22 @@
+#ifndef __GUI_BURST_H
+#define __GUI_BURST_H
+
+typedef void (*GuiBurstFunc) (void *data);
+
+/* While frozen, GUI refreshes are queued and each different one is run
+   only once at thaw. Freezing happens automatically when a server
+   connects and ends when its joins have settled. */
+void gui_burst_freeze(void);
+void gui_burst_thaw(void);
+int gui_burst_is_frozen(void);
+
+/* Returns TRUE if func(data) was queued to be run at thaw, FALSE if
+   we're not frozen and the caller should refresh right away. */
+int gui_burst_defer(GuiBurstFunc func, void *data);
+/* Forget the queued refreshes of data, it's being destroyed. */
+void gui_burst_cancel(void *data);
+
+void gui_bursts_init(void);
+void gui_bursts_deinit(void);
+
+#endif
@@ -22,6 +22,7 @@
 #include "modules.h"
 #include "signals.h"
 
+#include "gui-charset.h"
 #include "gui-frame.h"
 #include "gui-tab.h"
 #include "gui-window-view.h"
@@ -186,6 +187,12 @@ static gboolean event_key_press(GtkWidget *widget, GdkEventKey *event,
 	return FALSE;
 }
 
+static void event_hide(GtkWidget *widget, ChannelTitle *title)
+{
+	/* another item became active, stop editing */
+	gui_channel_topic_lock(GTK_WIDGET(title->topic));
+}
+
 GtkWidget *_get_title(WindowView *view, WindowItem *witem)
 {
 	GtkWidget *hbox, *topic;
@@ -200,8 +207,11 @@ GtkWidget *_get_title(WindowView *view, WindowItem *witem)
 	gui->titles = g_slist_prepend(gui->titles, title);
 
 	hbox = title->widget = gtk_hbox_new(FALSE, 0);
+	g_object_set_data(G_OBJECT(hbox), "title", title);
 	g_signal_connect(G_OBJECT(hbox), "destroy",
 			 G_CALLBACK(event_destroy), title);
+	g_signal_connect(G_OBJECT(hbox), "hide",
+			 G_CALLBACK(event_hide), title);
 
 	/* topic */
 	topic = gtk_entry_new();
@@ -228,6 +238,16 @@ GtkWidget *_get_title(WindowView *view, WindowItem *witem)
 	return hbox;
 }
 
+static void _update_title(WindowView *view, WindowItem *witem,
+			  GtkWidget *widget)
+{
+	ChannelTitle *title;
+
+	/* focus may have changed while we were hidden */
+	title = g_object_get_data(G_OBJECT(widget), "title");
+	title_set_colors(title);
+}
+
 static void sig_channel_created(Channel *channel)
 {
 	ChannelGui *gui;
@@ -236,6 +256,7 @@ static void sig_channel_created(Channel *channel)
 	gui->channel = channel;
 	gui->nicklist = gui_nicklist_new(channel);
 	gui->get_title = _get_title;
+	gui->update_title = _update_title;
 
 	MODULE_DATA_SET(channel, gui);
 
@@ -269,11 +290,9 @@ static void sig_channel_topic_changed(Channel *channel)
 	if (channel->topic == NULL)
 		text = NULL;
 	else {
-		text = g_locale_to_utf8(channel->topic, -1, NULL, NULL, NULL);
-		if (text == NULL) {
-			text = g_convert(channel->topic, strlen(channel->topic),
-					 "UTF-8", "CP1252", NULL, NULL, NULL);
-		}
+		text = gui_charset_to_utf8(gui_charset_find(channel->server,
+							    channel->name),
+					   channel->topic);
 	}
 
 	gui = CHANNEL_GUI(channel);
@@ -0,0 +1,273 @@
+/*
+ gui-charset.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "commands.h"
+#include "servers.h"
+#include "levels.h"
+#include "lib-config/iconfig.h"
+
+#include "printtext.h"
+
+#include "gui-charset.h"
+#include "gui-scan.h"
+
+/* converted to if the text is valid in no other charset */
+#define FALLBACK_CHARSET "CP1252"
+
+static GHashTable *charsets; /* "network/channel", "channel" or "network"
+				in lowercase => charset */
+static char *locale_charset; /* NULL if it's UTF-8 */
+
+/* each thread has its own open iconv handles, they can't be shared */
+static GStaticPrivate iconv_cache_key = G_STATIC_PRIVATE_INIT;
+
+static int iconv_cache_remove(char *key, GIConv cd)
+{
+	if (cd != (GIConv) -1)
+		g_iconv_close(cd);
+	g_free(key);
+	return TRUE;
+}
+
+static void iconv_cache_destroy(GHashTable *cache)
+{
+	g_hash_table_foreach_remove(cache, (GHRFunc) iconv_cache_remove,
+				    NULL);
+	g_hash_table_destroy(cache);
+}
+
+static GIConv iconv_get(const char *to, const char *from)
+{
+	GHashTable *cache;
+	GIConv cd;
+	char *key;
+	void *value;
+
+	cache = g_static_private_get(&iconv_cache_key);
+	if (cache == NULL) {
+		cache = g_hash_table_new((GHashFunc) g_str_hash,
+					 (GCompareFunc) g_str_equal);
+		g_static_private_set(&iconv_cache_key, cache,
+				     (GDestroyNotify) iconv_cache_destroy);
+	}
+
+	key = g_strconcat(from, ">", to, NULL);
+	if (g_hash_table_lookup_extended(cache, key, NULL, &value)) {
+		g_free(key);
+		return (GIConv) value;
+	}
+
+	/* unknown charsets are remembered too, as -1 */
+	cd = g_iconv_open(to, from);
+	g_hash_table_insert(cache, key, (void *) cd);
+	return cd;
+}
+
+static char *convert(const char *text, const char *to, const char *from)
+{
+	GIConv cd;
+
+	cd = iconv_get(to, from);
+	if (cd == (GIConv) -1)
+		return NULL;
+
+	/* a previous failed conversion may have left a shift state */
+	g_iconv(cd, NULL, NULL, NULL, NULL);
+	return g_convert_with_iconv(text, strlen(text), cd, NULL, NULL, NULL);
+}
+
+char *gui_charset_to_utf8(const char *charset, const char *text)
+{
+	char *str;
+
+	g_return_val_if_fail(text != NULL, NULL);
+
+	/* most of the text is plain ASCII or UTF-8 already */
+	if (gui_scan_utf8_validate(text, strlen(text)))
+		return g_strdup(text);
+
+	str = charset == NULL ? NULL : convert(text, "UTF-8", charset);
+	if (str == NULL && locale_charset != NULL)
+		str = convert(text, "UTF-8", locale_charset);
+	if (str == NULL) {
+		/* error - fallback to hardcoded charset (ms windows one) */
+		str = convert(text, "UTF-8", FALLBACK_CHARSET);
+	}
+	return str != NULL ? str : g_strdup(text);
+}
+
+char *gui_charset_from_utf8(const char *charset, const char *text)
+{
+	char *str;
+
+	g_return_val_if_fail(text != NULL, NULL);
+
+	if (charset == NULL)
+		charset = locale_charset;
+
+	str = charset == NULL ? NULL : convert(text, charset, "UTF-8");
+	return str != NULL ? str : g_strdup(text);
+}
+
+static const char *charset_lookup(const char *name)
+{
+	const char *charset;
+	char *key;
+
+	key = g_ascii_strdown(name, -1);
+	charset = g_hash_table_lookup(charsets, key);
+	g_free(key);
+	return charset;
+}
+
+const char *gui_charset_find(Server *server, const char *target)
+{
+	const char *network, *charset;
+	char *key;
+
+	if (server == NULL || g_hash_table_size(charsets) == 0)
+		return NULL;
+
+	network = server->connrec->chatnet != NULL ?
+		server->connrec->chatnet : server->tag;
+
+	if (target != NULL) {
+		key = g_strconcat(network, "/", target, NULL);
+		charset = charset_lookup(key);
+		g_free(key);
+
+		if (charset == NULL)
+			charset = charset_lookup(target);
+		if (charset != NULL)
+			return charset;
+	}
+
+	return charset_lookup(network);
+}
+
+static int charset_remove(char *key, char *value)
+{
+	g_free(key);
+	g_free(value);
+	return TRUE;
+}
+
+static void read_charsets(void)
+{
+	CONFIG_NODE *node;
+	GSList *tmp;
+
+	g_hash_table_foreach_remove(charsets, (GHRFunc) charset_remove, NULL);
+
+	node = iconfig_node_traverse("charsets", FALSE);
+	if (node == NULL)
+		return;
+
+	for (tmp = config_node_first(node->value); tmp != NULL;
+	     tmp = config_node_next(tmp)) {
+		node = tmp->data;
+
+		if (!has_node_value(node))
+			continue;
+
+		g_hash_table_insert(charsets, g_ascii_strdown(node->key, -1),
+				    g_strdup(node->value));
+	}
+}
+
+static void charset_print(char *key, char *value, Window *window)
+{
+	printtext_window(window, MSGLEVEL_CLIENTCRAP, "%s: %s", key, value);
+}
+
+/* SYNTAX: GUI CHARSET [[-]<network>|<channel>|<network>/<channel> [<charset>]] */
+static void cmd_gui_charset(const char *data)
+{
+	const char *charset;
+	char *key, *value;
+	GIConv cd;
+
+	key = g_strdup(data);
+	value = strchr(key, ' ');
+	if (value != NULL) {
+		*value++ = '\0';
+		while (*value == ' ') value++;
+	}
+
+	if (*key == '\0') {
+		if (g_hash_table_size(charsets) == 0) {
+			printtext_window(active_win, MSGLEVEL_CLIENTNOTICE,
+					 "No charsets set");
+		}
+		g_hash_table_foreach(charsets, (GHFunc) charset_print,
+				     active_win);
+	} else if (*key == '-') {
+		iconfig_set_str("charsets", key+1, NULL);
+		read_charsets();
+		printtext_window(active_win, MSGLEVEL_CLIENTNOTICE,
+				 "Removed charset of %s", key+1);
+	} else if (value == NULL || *value == '\0') {
+		charset = charset_lookup(key);
+		printtext_window(active_win, MSGLEVEL_CLIENTNOTICE, "%s: %s",
+				 key, charset != NULL ? charset :
+				 "(default)");
+	} else {
+		cd = g_iconv_open("UTF-8", value);
+		if (cd == (GIConv) -1) {
+			printtext_window(active_win, MSGLEVEL_CLIENTERROR,
+					 "Unknown charset: %s", value);
+		} else {
+			g_iconv_close(cd);
+			iconfig_set_str("charsets", key, value);
+			read_charsets();
+			printtext_window(active_win, MSGLEVEL_CLIENTNOTICE,
+					 "%s: %s", key, value);
+		}
+	}
+	g_free(key);
+}
+
+void gui_charsets_init(void)
+{
+	const char *charset;
+
+	/* resolved here so the print workers don't have to */
+	locale_charset = g_get_charset(&charset) ? NULL : g_strdup(charset);
+
+	charsets = g_hash_table_new((GHashFunc) g_str_hash,
+				    (GCompareFunc) g_str_equal);
+	read_charsets();
+
+	signal_add("setup reread", (SIGNAL_FUNC) read_charsets);
+	command_bind("gui charset", NULL, (SIGNAL_FUNC) cmd_gui_charset);
+}
+
+void gui_charsets_deinit(void)
+{
+	g_hash_table_foreach_remove(charsets, (GHRFunc) charset_remove, NULL);
+	g_hash_table_destroy(charsets);
+	g_free(locale_charset);
+
+	signal_remove("setup reread", (SIGNAL_FUNC) read_charsets);
+	command_unbind("gui charset", (SIGNAL_FUNC) cmd_gui_charset);
+}
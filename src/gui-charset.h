@@ -0,0 +1,21 @@
+#ifndef __GUI_CHARSET_H
+#define __GUI_CHARSET_H
+
+/* Charsets can be set per network, per channel or per channel in a
+   network with /GUI CHARSET, they're saved to the "charsets" block
+   of the config. */
+
+/* Returns the charset used by target (channel or query, may be NULL)
+   in server, or NULL if it's not set. */
+const char *gui_charset_find(Server *server, const char *target);
+
+/* Convert text to UTF-8 from charset, or from locale's charset if it's
+   NULL. Text that already is valid UTF-8 isn't converted. These can be
+   called from any thread. */
+char *gui_charset_to_utf8(const char *charset, const char *text);
+char *gui_charset_from_utf8(const char *charset, const char *text);
+
+void gui_charsets_init(void);
+void gui_charsets_deinit(void);
+
+#endif
@@ -42,6 +42,7 @@ GdkColor colors[COLORS] = {
 	{ 0, 0xffff, 0xffff, 0xffff } /* bold */
 };
 
+GdkColor extended_colors[EXTENDED_COLORS];
 
 GdkColor mirc_colors[MIRC_COLORS] = {
 	{ 0, 0xffff, 0xffff, 0xffff }, /* white */
@@ -61,3 +62,52 @@ GdkColor mirc_colors[MIRC_COLORS] = {
 	{ 0, 0x7b00, 0x7b00, 0x7b00 }, /* grey */
 	{ 0, 0xcd00, 0xd200, 0xcd00 } /* dark grey */
 };
+
+/* mIRC colors 16-98 */
+static const guint32 mirc_extended_rgb[MIRC_COLORS-16] = {
+	0x470000, 0x472100, 0x474700, 0x324700, 0x004700, 0x00472c,
+	0x004747, 0x002747, 0x000047, 0x2e0047, 0x470047, 0x47002a,
+	0x740000, 0x743a00, 0x747400, 0x517400, 0x007400, 0x007449,
+	0x007474, 0x004074, 0x000074, 0x4b0074, 0x740074, 0x740045,
+	0xb50000, 0xb56300, 0xb5b500, 0x7db500, 0x00b500, 0x00b571,
+	0x00b5b5, 0x0063b5, 0x0000b5, 0x7500b5, 0xb500b5, 0xb5006b,
+	0xff0000, 0xff8c00, 0xffff00, 0xb2ff00, 0x00ff00, 0x00ffa0,
+	0x00ffff, 0x008cff, 0x0000ff, 0xa500ff, 0xff00ff, 0xff0098,
+	0xff5959, 0xffb459, 0xffff71, 0xcfff60, 0x6fff6f, 0x65ffc9,
+	0x6dffff, 0x59b4ff, 0x5959ff, 0xc459ff, 0xff66ff, 0xff59bc,
+	0xff9c9c, 0xffd39c, 0xffff9c, 0xe2ff9c, 0x9cff9c, 0x9cffdb,
+	0x9cffff, 0x9cd3ff, 0x9c9cff, 0xdc9cff, 0xff9cff, 0xff94d3,
+	0x000000, 0x131313, 0x282828, 0x363636, 0x4d4d4d, 0x656565,
+	0x818181, 0x9f9f9f, 0xbcbcbc, 0xe2e2e2, 0xffffff
+};
+
+static void color_set_rgb(GdkColor *color, guint32 rgb)
+{
+	color->pixel = 0;
+	color->red = ((rgb >> 16) & 0xff) * 0x101;
+	color->green = ((rgb >> 8) & 0xff) * 0x101;
+	color->blue = (rgb & 0xff) * 0x101;
+}
+
+void gui_colors_init(void)
+{
+	static const int cube[] = { 0, 0x5f, 0x87, 0xaf, 0xd7, 0xff };
+	int i, level;
+
+	for (i = 16; i < MIRC_COLORS; i++)
+		color_set_rgb(&mirc_colors[i], mirc_extended_rgb[i-16]);
+
+	/* the 16 base colors are the same as ours,
+	   then a 6x6x6 color cube and 24 greys */
+	memcpy(extended_colors, colors, sizeof(GdkColor) * DEFAULT_COLORS);
+	for (i = 0; i < 216; i++) {
+		color_set_rgb(&extended_colors[16+i],
+			      (cube[i / 36] << 16) |
+			      (cube[(i / 6) % 6] << 8) | cube[i % 6]);
+	}
+	for (i = 0; i < 24; i++) {
+		level = 8 + i*10;
+		color_set_rgb(&extended_colors[232+i],
+			      (level << 16) | (level << 8) | level);
+	}
+}
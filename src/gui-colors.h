@@ -2,7 +2,15 @@
 #define __GUI_COLORS_H
 
 #define DEFAULT_COLORS 16
-#define MIRC_COLORS 16
+#define EXTENDED_COLORS 256 /* xterm's 256 color palette */
+#define MIRC_COLORS 99 /* 16 classic + 83 extended mIRC colors */
+
+/* 24bit colors given as 0xRRGGBB in fg/bg, in case the core doesn't
+   know about them yet */
+#ifndef GUI_PRINT_FLAG_COLOR_24_FG
+#  define GUI_PRINT_FLAG_COLOR_24_FG 0x0200
+#  define GUI_PRINT_FLAG_COLOR_24_BG 0x0400
+#endif
 
 enum {
 	COLOR_BOLD = DEFAULT_COLORS,
@@ -11,6 +19,9 @@ enum {
 };
 
 extern GdkColor colors[COLORS];
+extern GdkColor extended_colors[EXTENDED_COLORS];
 extern GdkColor mirc_colors[MIRC_COLORS];
 
+void gui_colors_init(void);
+
 #endif
@@ -0,0 +1,118 @@
+/*
+ gui-commands.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "module.h"
+#include "signals.h"
+#include "commands.h"
+#include "levels.h"
+
+#include "fe-windows.h"
+#include "printtext.h"
+
+/* SYNTAX: GUI STATS */
+static void cmd_gui_stats(const char *data)
+{
+	/* each module prints its own counters */
+	signal_emit("gui stats", 1, active_win);
+}
+
+/* SYNTAX: GUI BENCH SWITCH [<count>] */
+static void cmd_gui_bench_switch(const char *data)
+{
+	GTimer *timer;
+	Window *window;
+	double secs, max, prev;
+	int refnum, orig_refnum, last, count, i;
+
+	count = *data == '\0' ? 300 : atoi(data);
+	last = windows_refnum_last();
+	if (count <= 0 || last <= 1)
+		return;
+
+	orig_refnum = active_win->refnum;
+	refnum = orig_refnum;
+	max = prev = 0;
+
+	timer = g_timer_new();
+	for (i = 0; i < count; i++) {
+		/* windows may get destroyed while we run the main loop,
+		   so look them up by refnum each time */
+		do {
+			refnum = refnum >= last ? 1 : refnum+1;
+			window = window_find_refnum(refnum);
+		} while (window == NULL);
+
+		window_set_active(window);
+
+		/* include the redrawing GTK does after the switch */
+		while (gtk_events_pending())
+			gtk_main_iteration();
+
+		secs = g_timer_elapsed(timer, NULL);
+		if (secs-prev > max)
+			max = secs-prev;
+		prev = secs;
+	}
+	secs = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	window = window_find_refnum(orig_refnum);
+	if (window != NULL)
+		window_set_active(window);
+
+	printtext_window(active_win, MSGLEVEL_CLIENTNOTICE,
+			 "%d window switches took %.1f ms, "
+			 "%.3f ms average, %.3f ms max",
+			 count, secs*1000, secs*1000/count, max*1000);
+}
+
+static void cmd_gui_bench(const char *data, Server *server, WindowItem *item)
+{
+	command_runsub("gui bench", data, server, item);
+}
+
+static void cmd_gui_selftest(const char *data, Server *server,
+			     WindowItem *item)
+{
+	command_runsub("gui selftest", data, server, item);
+}
+
+static void cmd_gui(const char *data, Server *server, WindowItem *item)
+{
+	command_runsub("gui", data, server, item);
+}
+
+void gui_commands_init(void)
+{
+	command_bind("gui", NULL, (SIGNAL_FUNC) cmd_gui);
+	command_bind("gui stats", NULL, (SIGNAL_FUNC) cmd_gui_stats);
+	command_bind("gui bench", NULL, (SIGNAL_FUNC) cmd_gui_bench);
+	command_bind("gui bench switch", NULL, (SIGNAL_FUNC) cmd_gui_bench_switch);
+	command_bind("gui selftest", NULL, (SIGNAL_FUNC) cmd_gui_selftest);
+}
+
+void gui_commands_deinit(void)
+{
+	command_unbind("gui", (SIGNAL_FUNC) cmd_gui);
+	command_unbind("gui stats", (SIGNAL_FUNC) cmd_gui_stats);
+	command_unbind("gui bench", (SIGNAL_FUNC) cmd_gui_bench);
+	command_unbind("gui bench switch", (SIGNAL_FUNC) cmd_gui_bench_switch);
+	command_unbind("gui selftest", (SIGNAL_FUNC) cmd_gui_selftest);
+}
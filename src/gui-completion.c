@@ -0,0 +1,725 @@
+/*
+ gui-completion.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "module.h"
+#include "signals.h"
+#include "misc.h"
+#include "settings.h"
+#include "servers.h"
+#include "channels.h"
+#include "nicklist.h"
+
+#include "gui-entry.h"
+#include "gui-completion.h"
+
+/* how many candidates the popup shows at a time */
+#define MAX_POPUP_ROWS 15
+
+typedef struct _TrieNode TrieNode;
+
+typedef struct {
+	char *nick;
+	unsigned int stamp; /* when the nick last spoke, 0 = never */
+} CompletionNick;
+
+struct _TrieNode {
+	TrieNode *child, *next; /* siblings are sorted by chr */
+	CompletionNick *nick; /* nick ending at this node */
+	char chr;
+};
+
+typedef struct {
+	TrieNode root;
+	GHashTable *nicks; /* casefolded nick => CompletionNick */
+} NickIndex;
+
+typedef struct {
+	Entry *entry;
+	Channel *channel;
+
+	GtkWidget *popup, *tree;
+	GtkListStore *store;
+
+	GPtrArray *matches; /* nicks matching the word, most recent first */
+	int selected; /* -1 = nothing completed yet */
+
+	int word_start, word_end; /* replaced text, in characters */
+	char *text; /* entry text after our last change */
+
+	unsigned int changing:1;
+} Completion;
+
+static GHashTable *indexes; /* Channel => NickIndex */
+static GSList *completions;
+static unsigned int spoke_stamp;
+
+/* rfc1459 casemapping */
+static char *nick_casefold(const char *nick)
+{
+	char *str, *p;
+
+	str = g_strdup(nick);
+	for (p = str; *p != '\0'; p++) {
+		switch (*p) {
+		case '[':
+			*p = '{';
+			break;
+		case ']':
+			*p = '}';
+			break;
+		case '\\':
+			*p = '|';
+			break;
+		case '~':
+			*p = '^';
+			break;
+		default:
+			*p = i_tolower(*p);
+			break;
+		}
+	}
+	return str;
+}
+
+static TrieNode *trie_child(TrieNode *node, char chr, int create)
+{
+	TrieNode **pos, *child;
+
+	for (pos = &node->child; *pos != NULL; pos = &(*pos)->next) {
+		if ((*pos)->chr == chr)
+			return *pos;
+		if ((*pos)->chr > chr)
+			break;
+	}
+
+	if (!create)
+		return NULL;
+
+	child = g_new0(TrieNode, 1);
+	child->chr = chr;
+	child->next = *pos;
+	*pos = child;
+	return child;
+}
+
+static TrieNode *trie_find(TrieNode *node, const char *key, int create)
+{
+	for (; *key != '\0' && node != NULL; key++)
+		node = trie_child(node, *key, create);
+	return node;
+}
+
+/* Returns TRUE if the node became empty and was freed */
+static int trie_remove(TrieNode *node, const char *key)
+{
+	TrieNode **pos, *child;
+
+	if (*key == '\0') {
+		node->nick = NULL;
+		return node->child == NULL;
+	}
+
+	for (pos = &node->child; *pos != NULL; pos = &(*pos)->next) {
+		if ((*pos)->chr == *key)
+			break;
+	}
+
+	child = *pos;
+	if (child == NULL || !trie_remove(child, key+1))
+		return FALSE;
+
+	*pos = child->next;
+	g_free(child);
+	return node->child == NULL && node->nick == NULL;
+}
+
+static void trie_free_children(TrieNode *node)
+{
+	TrieNode *child, *next;
+
+	for (child = node->child; child != NULL; child = next) {
+		next = child->next;
+		trie_free_children(child);
+		g_free(child);
+	}
+	node->child = NULL;
+}
+
+static void trie_collect(TrieNode *node, GPtrArray *array)
+{
+	TrieNode *child;
+
+	if (node->nick != NULL)
+		g_ptr_array_add(array, node->nick);
+
+	for (child = node->child; child != NULL; child = child->next)
+		trie_collect(child, array);
+}
+
+static NickIndex *nick_index_get(Channel *channel, int create)
+{
+	NickIndex *index;
+
+	index = g_hash_table_lookup(indexes, channel);
+	if (index == NULL && create) {
+		index = g_new0(NickIndex, 1);
+		index->nicks = g_hash_table_new((GHashFunc) g_str_hash,
+						(GCompareFunc) g_str_equal);
+		g_hash_table_insert(indexes, channel, index);
+	}
+	return index;
+}
+
+static void nick_index_add(NickIndex *index, const char *nick)
+{
+	CompletionNick *rec;
+	TrieNode *node;
+	char *key;
+
+	key = nick_casefold(nick);
+	node = trie_find(&index->root, key, TRUE);
+	if (node->nick != NULL) {
+		/* case change only */
+		g_free(node->nick->nick);
+		node->nick->nick = g_strdup(nick);
+		g_free(key);
+		return;
+	}
+
+	rec = g_new0(CompletionNick, 1);
+	rec->nick = g_strdup(nick);
+	node->nick = rec;
+	g_hash_table_insert(index->nicks, key, rec);
+}
+
+static void nick_index_remove(NickIndex *index, const char *nick)
+{
+	CompletionNick *rec;
+	gpointer key;
+	char *folded;
+
+	folded = nick_casefold(nick);
+	if (g_hash_table_lookup_extended(index->nicks, folded, &key,
+					 (gpointer *) &rec)) {
+		g_hash_table_remove(index->nicks, key);
+		trie_remove(&index->root, folded);
+
+		g_free(key);
+		g_free(rec->nick);
+		g_free(rec);
+	}
+	g_free(folded);
+}
+
+static void nick_index_touch(NickIndex *index, const char *nick)
+{
+	CompletionNick *rec;
+	char *key;
+
+	key = nick_casefold(nick);
+	rec = g_hash_table_lookup(index->nicks, key);
+	if (rec != NULL)
+		rec->stamp = ++spoke_stamp;
+	g_free(key);
+}
+
+static int nick_rec_free(char *key, CompletionNick *rec)
+{
+	g_free(key);
+	g_free(rec->nick);
+	g_free(rec);
+	return TRUE;
+}
+
+static void nick_index_destroy(NickIndex *index)
+{
+	g_hash_table_foreach_remove(index->nicks, (GHRFunc) nick_rec_free, NULL);
+	g_hash_table_destroy(index->nicks);
+	trie_free_children(&index->root);
+	g_free(index);
+}
+
+static int nick_match_cmp(CompletionNick **rec1, CompletionNick **rec2)
+{
+	if ((*rec1)->stamp != (*rec2)->stamp)
+		return (*rec1)->stamp > (*rec2)->stamp ? -1 : 1;
+	return g_ascii_strcasecmp((*rec1)->nick, (*rec2)->nick);
+}
+
+/* Returns the nicks starting with prefix, most recently active first.
+   Own nick is never included. */
+static GPtrArray *nick_index_match(Channel *channel, const char *prefix)
+{
+	NickIndex *index;
+	GPtrArray *recs, *matches;
+	TrieNode *node;
+	char *key;
+	int i;
+
+	matches = g_ptr_array_new();
+	index = nick_index_get(channel, FALSE);
+	if (index == NULL)
+		return matches;
+
+	key = nick_casefold(prefix);
+	node = trie_find(&index->root, key, FALSE);
+	g_free(key);
+	if (node == NULL)
+		return matches;
+
+	recs = g_ptr_array_new();
+	trie_collect(node, recs);
+	g_ptr_array_sort(recs, (GCompareFunc) nick_match_cmp);
+
+	for (i = 0; i < (int)recs->len; i++) {
+		CompletionNick *rec = g_ptr_array_index(recs, i);
+
+		if (channel->ownnick != NULL &&
+		    strcmp(rec->nick, channel->ownnick->nick) == 0)
+			continue;
+		g_ptr_array_add(matches, g_strdup(rec->nick));
+	}
+	g_ptr_array_free(recs, TRUE);
+	return matches;
+}
+
+static void matches_free(GPtrArray *matches)
+{
+	int i;
+
+	for (i = 0; i < (int)matches->len; i++)
+		g_free(g_ptr_array_index(matches, i));
+	g_ptr_array_free(matches, TRUE);
+}
+
+/* Find the word before cursor. Returns FALSE if it's not something we
+   should complete nicks for. */
+static int completion_find_word(Completion *comp, int *start, int *end,
+				char **prefix)
+{
+	const char *text, *cmdchars, *cursor, *p, *word;
+
+	if (comp->channel == NULL)
+		return FALSE;
+
+	text = gtk_entry_get_text(comp->entry->entry);
+	cmdchars = settings_get_str("cmdchars");
+	if (*text != '\0' && strchr(cmdchars, *text) != NULL) {
+		/* commands are left to the core completion */
+		return FALSE;
+	}
+
+	cursor = g_utf8_offset_to_pointer(text,
+		gtk_editable_get_position(GTK_EDITABLE(comp->entry->entry)));
+	for (word = cursor; word > text && word[-1] != ' '; word--) ;
+	if (word == cursor)
+		return FALSE;
+
+	for (p = cursor; *p != '\0' && *p != ' '; p++) ;
+
+	*start = g_utf8_pointer_to_offset(text, word);
+	*end = g_utf8_pointer_to_offset(text, p);
+	*prefix = g_strndup(word, (int) (cursor-word));
+	return TRUE;
+}
+
+static void event_popup_destroy(GtkWidget *widget, Completion *comp)
+{
+	comp->popup = NULL;
+}
+
+static void popup_create(Completion *comp)
+{
+	GtkWidget *frame;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	comp->store = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_STRING);
+
+	comp->popup = gtk_window_new(GTK_WINDOW_POPUP);
+	g_signal_connect(G_OBJECT(comp->popup), "destroy",
+			 G_CALLBACK(event_popup_destroy), comp);
+
+	frame = gtk_frame_new(NULL);
+	gtk_frame_set_shadow_type(GTK_FRAME(frame), GTK_SHADOW_OUT);
+	gtk_container_add(GTK_CONTAINER(comp->popup), frame);
+
+	comp->tree = gtk_tree_view_new_with_model(GTK_TREE_MODEL(comp->store));
+	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(comp->tree), FALSE);
+	gtk_container_add(GTK_CONTAINER(frame), comp->tree);
+
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(NULL, renderer,
+							  "text", 0,
+							  "foreground", 1,
+							  NULL);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(comp->tree), column);
+
+	gtk_widget_show_all(frame);
+}
+
+static void popup_update(Completion *comp)
+{
+	GtkWidget *widget;
+	GtkTreeIter iter;
+	GtkTreePath *path;
+	GtkRequisition req;
+	char *str;
+	int i, first, last, x, y;
+
+	if (comp->popup == NULL)
+		popup_create(comp);
+
+	/* show the page containing the selected nick */
+	first = comp->selected < 0 ? 0 :
+		comp->selected / MAX_POPUP_ROWS * MAX_POPUP_ROWS;
+	last = MIN(first + MAX_POPUP_ROWS, (int)comp->matches->len);
+
+	gtk_list_store_clear(comp->store);
+	for (i = first; i < last; i++) {
+		gtk_list_store_append(comp->store, &iter);
+		gtk_list_store_set(comp->store, &iter,
+				   0, g_ptr_array_index(comp->matches, i), -1);
+	}
+	if (first > 0 || last < (int)comp->matches->len) {
+		str = g_strdup_printf("%d-%d of %d", first+1, last,
+				      comp->matches->len);
+		gtk_list_store_append(comp->store, &iter);
+		gtk_list_store_set(comp->store, &iter,
+				   0, str, 1, "gray50", -1);
+		g_free(str);
+	}
+
+	if (comp->selected >= 0) {
+		path = gtk_tree_path_new_from_indices(comp->selected - first, -1);
+		gtk_tree_selection_select_path(gtk_tree_view_get_selection(GTK_TREE_VIEW(comp->tree)), path);
+		gtk_tree_path_free(path);
+	}
+
+	/* above the entry, starting from the completed word */
+	widget = comp->entry->widget;
+	gdk_window_get_origin(widget->window, &x, &y);
+	gtk_widget_size_request(comp->popup, &req);
+	gtk_window_move(GTK_WINDOW(comp->popup),
+			x + widget->allocation.x,
+			MAX(y + widget->allocation.y - req.height, 0));
+	gtk_widget_show(comp->popup);
+}
+
+static void completion_reset(Completion *comp)
+{
+	if (comp->popup != NULL)
+		gtk_widget_hide(comp->popup);
+
+	if (comp->matches != NULL) {
+		matches_free(comp->matches);
+		comp->matches = NULL;
+	}
+	g_free(comp->text);
+	comp->text = NULL;
+	comp->channel = NULL;
+}
+
+static void completion_apply(Completion *comp)
+{
+	GtkEditable *editable;
+	NickIndex *index;
+	const char *nick;
+	char *str;
+	int pos;
+
+	nick = g_ptr_array_index(comp->matches, comp->selected);
+	if (comp->word_start == 0) {
+		str = g_strconcat(nick, settings_get_str("completion_char"),
+				  " ", NULL);
+	} else {
+		str = g_strconcat(nick, " ", NULL);
+	}
+
+	editable = GTK_EDITABLE(comp->entry->entry);
+	comp->changing = TRUE;
+	gtk_editable_delete_text(editable, comp->word_start, comp->word_end);
+	pos = comp->word_start;
+	gtk_editable_insert_text(editable, str, strlen(str), &pos);
+	gtk_editable_set_position(editable, pos);
+	comp->changing = FALSE;
+	g_free(str);
+
+	comp->word_end = pos;
+	g_free(comp->text);
+	comp->text = g_strdup(gtk_entry_get_text(comp->entry->entry));
+
+	/* completed nicks are likely to be completed again */
+	index = nick_index_get(comp->channel, FALSE);
+	if (index != NULL)
+		nick_index_touch(index, nick);
+}
+
+/* refilter the popup while typing */
+static void event_changed(GtkEditable *editable, Completion *comp)
+{
+	char *prefix;
+	int start, end;
+
+	if (comp->changing || comp->matches == NULL)
+		return;
+
+	if (!completion_find_word(comp, &start, &end, &prefix) ||
+	    start != comp->word_start) {
+		completion_reset(comp);
+		return;
+	}
+
+	matches_free(comp->matches);
+	comp->matches = nick_index_match(comp->channel, prefix);
+	g_free(prefix);
+
+	if (comp->matches->len == 0) {
+		completion_reset(comp);
+		return;
+	}
+
+	comp->selected = -1;
+	comp->word_end = end;
+	g_free(comp->text);
+	comp->text = g_strdup(gtk_entry_get_text(comp->entry->entry));
+	popup_update(comp);
+}
+
+static Completion *completion_get(Entry *entry)
+{
+	Completion *comp;
+
+	comp = g_object_get_data(G_OBJECT(entry->widget), "Completion");
+	if (comp != NULL)
+		return comp;
+
+	comp = g_new0(Completion, 1);
+	comp->entry = entry;
+	g_object_set_data(G_OBJECT(entry->widget), "Completion", comp);
+	g_signal_connect(G_OBJECT(entry->widget), "changed",
+			 G_CALLBACK(event_changed), comp);
+
+	completions = g_slist_prepend(completions, comp);
+	return comp;
+}
+
+static void completion_destroy(Completion *comp)
+{
+	completions = g_slist_remove(completions, comp);
+
+	completion_reset(comp);
+	if (comp->popup != NULL)
+		gtk_widget_destroy(comp->popup);
+	if (comp->store != NULL)
+		g_object_unref(G_OBJECT(comp->store));
+	g_free(comp);
+}
+
+int gui_completion_complete(Entry *entry, int backward)
+{
+	Completion *comp;
+	Channel *channel;
+	char *prefix;
+	int count;
+
+	channel = CHANNEL(entry->active_win->active);
+	if (channel == NULL || nick_index_get(channel, FALSE) == NULL)
+		return FALSE;
+
+	comp = completion_get(entry);
+	if (comp->matches != NULL &&
+	    (comp->channel != channel ||
+	     strcmp(comp->text, gtk_entry_get_text(entry->entry)) != 0))
+		completion_reset(comp);
+
+	if (comp->matches == NULL) {
+		/* start a new completion */
+		comp->channel = channel;
+		if (!completion_find_word(comp, &comp->word_start,
+					  &comp->word_end, &prefix)) {
+			comp->channel = NULL;
+			return FALSE;
+		}
+
+		comp->matches = nick_index_match(channel, prefix);
+		g_free(prefix);
+
+		if (comp->matches->len == 0) {
+			completion_reset(comp);
+			return FALSE;
+		}
+		comp->selected = -1;
+	}
+
+	count = comp->matches->len;
+	if (comp->selected < 0)
+		comp->selected = backward ? count-1 : 0;
+	else if (backward)
+		comp->selected = (comp->selected + count-1) % count;
+	else
+		comp->selected = (comp->selected + 1) % count;
+
+	completion_apply(comp);
+
+	if (count > 1)
+		popup_update(comp);
+	else
+		completion_reset(comp);
+	return TRUE;
+}
+
+static void completions_reset_channel(Channel *channel)
+{
+	GSList *tmp;
+
+	for (tmp = completions; tmp != NULL; tmp = tmp->next) {
+		Completion *comp = tmp->data;
+
+		if (channel == NULL || comp->channel == channel)
+			completion_reset(comp);
+	}
+}
+
+static void sig_nicklist_new(Channel *channel, Nick *nick)
+{
+	nick_index_add(nick_index_get(channel, TRUE), nick->nick);
+}
+
+static void sig_nicklist_remove(Channel *channel, Nick *nick)
+{
+	NickIndex *index;
+
+	index = nick_index_get(channel, FALSE);
+	if (index != NULL)
+		nick_index_remove(index, nick->nick);
+}
+
+static void sig_nicklist_changed(Channel *channel, Nick *nick,
+				 const char *oldnick)
+{
+	NickIndex *index;
+	CompletionNick *rec;
+	unsigned int stamp;
+	char *key;
+
+	index = nick_index_get(channel, FALSE);
+	if (index == NULL)
+		return;
+
+	/* keep the activity over nick changes */
+	key = nick_casefold(oldnick);
+	rec = g_hash_table_lookup(index->nicks, key);
+	stamp = rec == NULL ? 0 : rec->stamp;
+	g_free(key);
+
+	nick_index_remove(index, oldnick);
+	nick_index_add(index, nick->nick);
+
+	key = nick_casefold(nick->nick);
+	rec = g_hash_table_lookup(index->nicks, key);
+	if (rec != NULL)
+		rec->stamp = stamp;
+	g_free(key);
+}
+
+static void sig_channel_destroyed(Channel *channel)
+{
+	NickIndex *index;
+
+	completions_reset_channel(channel);
+
+	index = nick_index_get(channel, FALSE);
+	if (index != NULL) {
+		g_hash_table_remove(indexes, channel);
+		nick_index_destroy(index);
+	}
+}
+
+static void sig_message_public(Server *server, const char *msg,
+			       const char *nick, const char *address,
+			       const char *target)
+{
+	Channel *channel;
+	NickIndex *index;
+
+	channel = channel_find(server, target);
+	if (channel == NULL)
+		return;
+
+	index = nick_index_get(channel, FALSE);
+	if (index != NULL)
+		nick_index_touch(index, nick);
+}
+
+static void sig_window_changed(void)
+{
+	completions_reset_channel(NULL);
+}
+
+static void sig_entry_destroyed(Entry *entry)
+{
+	Completion *comp;
+
+	comp = g_object_get_data(G_OBJECT(entry->widget), "Completion");
+	if (comp != NULL) {
+		g_object_set_data(G_OBJECT(entry->widget), "Completion", NULL);
+		completion_destroy(comp);
+	}
+}
+
+static int nick_index_free(Channel *channel, NickIndex *index)
+{
+	nick_index_destroy(index);
+	return TRUE;
+}
+
+void gui_completions_init(void)
+{
+	indexes = g_hash_table_new((GHashFunc) g_direct_hash,
+				   (GCompareFunc) g_direct_equal);
+	completions = NULL;
+	spoke_stamp = 0;
+
+	signal_add("nicklist new", (SIGNAL_FUNC) sig_nicklist_new);
+	signal_add("nicklist remove", (SIGNAL_FUNC) sig_nicklist_remove);
+	signal_add("nicklist changed", (SIGNAL_FUNC) sig_nicklist_changed);
+	signal_add("channel destroyed", (SIGNAL_FUNC) sig_channel_destroyed);
+	signal_add("message public", (SIGNAL_FUNC) sig_message_public);
+	signal_add("window changed", (SIGNAL_FUNC) sig_window_changed);
+	signal_add("gui entry destroyed", (SIGNAL_FUNC) sig_entry_destroyed);
+}
+
+void gui_completions_deinit(void)
+{
+	while (completions != NULL)
+		completion_destroy(completions->data);
+
+	g_hash_table_foreach_remove(indexes, (GHRFunc) nick_index_free, NULL);
+	g_hash_table_destroy(indexes);
+
+	signal_remove("nicklist new", (SIGNAL_FUNC) sig_nicklist_new);
+	signal_remove("nicklist remove", (SIGNAL_FUNC) sig_nicklist_remove);
+	signal_remove("nicklist changed", (SIGNAL_FUNC) sig_nicklist_changed);
+	signal_remove("channel destroyed", (SIGNAL_FUNC) sig_channel_destroyed);
+	signal_remove("message public", (SIGNAL_FUNC) sig_message_public);
+	signal_remove("window changed", (SIGNAL_FUNC) sig_window_changed);
+	signal_remove("gui entry destroyed", (SIGNAL_FUNC) sig_entry_destroyed);
+}
@@ -0,0 +1,12 @@
+#ifndef __GUI_COMPLETION_H
+#define __GUI_COMPLETION_H
+
+/* Complete the nick before cursor from the channel's nick index, showing
+   the other candidates in a popup. Returns FALSE if there was nothing to
+   complete, so the core completion should be tried instead. */
+int gui_completion_complete(Entry *entry, int backward);
+
+void gui_completions_init(void);
+void gui_completions_deinit(void);
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ gui-context-expand.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+
+#include "gui-window.h"
+#include "gui-window-view.h"
+#include "gui-window-context.h"
+#include "gui-context-expand.h"
+
+typedef struct {
+	GtkTextMark *mark; /* at the start of the "expand" text */
+	char *text; /* what was cut from the line */
+} Expand;
+
+typedef struct {
+	WindowGui *window;
+	Expand *expand;
+} ExpandClick;
+
+static GHashTable *expands; /* WindowGui => GQueue of Expand, oldest first */
+
+static void expand_free(WindowGui *window, Expand *expand)
+{
+	g_object_set_data(G_OBJECT(expand->mark), "expand", NULL);
+	gtk_text_buffer_delete_mark(window->buffer, expand->mark);
+	g_free(expand->text);
+	g_free(expand);
+}
+
+void gui_context_expand_add(WindowGui *window, const char *text)
+{
+	GtkTextIter iter;
+	GtkTextTag *tag;
+	GQueue *queue;
+	Expand *expand;
+	char *str;
+
+	tag = gtk_text_tag_table_lookup(window->tagtable, "expand");
+	if (tag == NULL) {
+		tag = gui_window_context_create_tag(window, "expand");
+		g_object_set(G_OBJECT(tag), "underline", PANGO_UNDERLINE_SINGLE,
+			     "style", PANGO_STYLE_ITALIC, NULL);
+	}
+
+	queue = g_hash_table_lookup(expands, window);
+	if (queue == NULL) {
+		queue = g_queue_new();
+		g_hash_table_insert(expands, window, queue);
+	}
+
+	expand = g_new0(Expand, 1);
+	expand->text = g_strdup(text);
+
+	gtk_text_buffer_get_end_iter(window->buffer, &iter);
+	expand->mark = gtk_text_buffer_create_mark(window->buffer, NULL,
+						   &iter, TRUE);
+	g_object_set_data(G_OBJECT(expand->mark), "expand", expand);
+	g_queue_push_tail(queue, expand);
+
+	str = g_strdup_printf(" [%ld more characters]",
+			      g_utf8_strlen(text, -1));
+	gtk_text_buffer_insert_with_tags(window->buffer, &iter, str, -1,
+					 tag, NULL);
+	g_free(str);
+}
+
+void gui_context_expand_trim(WindowGui *window, int lines)
+{
+	GtkTextIter iter;
+	GQueue *queue;
+	Expand *expand;
+
+	queue = g_hash_table_lookup(expands, window);
+	if (queue == NULL)
+		return;
+
+	while ((expand = g_queue_peek_head(queue)) != NULL) {
+		gtk_text_buffer_get_iter_at_mark(window->buffer, &iter,
+						 expand->mark);
+		if (gtk_text_iter_get_line(&iter) >= lines)
+			break;
+
+		g_queue_pop_head(queue);
+		expand_free(window, expand);
+	}
+}
+
+static Expand *expand_find(GtkTextIter *iter, GtkTextTag *tag)
+{
+	GSList *marks, *tmp;
+	Expand *expand;
+
+	/* go to beginning of the tag, where the mark is */
+	while (!gtk_text_iter_begins_tag(iter, tag) &&
+	       gtk_text_iter_backward_char(iter)) ;
+
+	expand = NULL;
+	marks = gtk_text_iter_get_marks(iter);
+	for (tmp = marks; tmp != NULL; tmp = tmp->next) {
+		expand = g_object_get_data(G_OBJECT(tmp->data), "expand");
+		if (expand != NULL)
+			break;
+	}
+	g_slist_free(marks);
+	return expand;
+}
+
+static void expand_line(WindowGui *window, Expand *expand)
+{
+	GtkTextIter start_iter, end_iter;
+	GtkTextTag *tag;
+	GQueue *queue;
+	int offset;
+
+	tag = gtk_text_tag_table_lookup(window->tagtable, "expand");
+
+	gtk_text_buffer_get_iter_at_mark(window->buffer, &start_iter,
+					 expand->mark);
+	end_iter = start_iter;
+	gtk_text_iter_forward_to_tag_toggle(&end_iter, tag);
+	gtk_text_buffer_delete(window->buffer, &start_iter, &end_iter);
+
+	/* the full text is only scanned for context words now that
+	   someone actually wants to see it */
+	offset = gtk_text_iter_get_offset(&start_iter);
+	gtk_text_buffer_insert(window->buffer, &start_iter, expand->text, -1);
+	gtk_text_buffer_get_iter_at_offset(window->buffer, &start_iter, offset);
+	gui_window_print_mark_context(window, NULL, &start_iter,
+				      expand->text, NULL);
+
+	queue = g_hash_table_lookup(expands, window);
+	g_queue_remove(queue, expand);
+	expand_free(window, expand);
+}
+
+static gboolean expand_idle(ExpandClick *click)
+{
+	GQueue *queue;
+
+	/* the line may have been scrolled away already */
+	queue = g_hash_table_lookup(expands, click->window);
+	if (queue != NULL && g_queue_find(queue, click->expand) != NULL)
+		expand_line(click->window, click->expand);
+
+	g_free(click);
+	return FALSE;
+}
+
+static void sig_window_press(Window *window, const char *word,
+			     GtkTextTag *tag, GdkEventButton *event,
+			     GtkTextView *view)
+{
+	ExpandClick *click;
+	GtkTextIter iter;
+	Expand *expand;
+	int x, y;
+
+	if (strcmp(tag->name, "expand") != 0 || event->button != 1)
+		return;
+
+	gtk_text_view_window_to_buffer_coords(view, GTK_TEXT_WINDOW_TEXT,
+					      event->x, event->y, &x, &y);
+	gtk_text_view_get_iter_at_location(view, &iter, x, y);
+
+	expand = expand_find(&iter, tag);
+	if (expand != NULL) {
+		/* text view is still handling the event,
+		   don't change the buffer under it */
+		click = g_new0(ExpandClick, 1);
+		click->window = WINDOW_GUI(window);
+		click->expand = expand;
+		g_idle_add((GSourceFunc) expand_idle, click);
+	}
+	signal_stop();
+}
+
+static void sig_gui_window_destroyed(WindowGui *window)
+{
+	GQueue *queue;
+	Expand *expand;
+
+	queue = g_hash_table_lookup(expands, window);
+	if (queue == NULL)
+		return;
+
+	g_hash_table_remove(expands, window);
+	while ((expand = g_queue_pop_head(queue)) != NULL)
+		expand_free(window, expand);
+	g_queue_free(queue);
+}
+
+void gui_context_expand_init(void)
+{
+	expands = g_hash_table_new((GHashFunc) g_direct_hash,
+				   (GCompareFunc) g_direct_equal);
+
+	signal_add("gui window context press", (SIGNAL_FUNC) sig_window_press);
+	signal_add("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+}
+
+void gui_context_expand_deinit(void)
+{
+	g_hash_table_destroy(expands);
+
+	signal_remove("gui window context press", (SIGNAL_FUNC) sig_window_press);
+	signal_remove("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+}
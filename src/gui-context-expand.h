@@ -0,0 +1,16 @@
+#ifndef __GUI_CONTEXT_EXPAND_H
+#define __GUI_CONTEXT_EXPAND_H
+
+/* Lines longer than gui_line_max_chars are shown cut, followed by an
+   "expand" context tag. Clicking it shows the rest of the line. */
+
+/* add the expand tag for text that was cut from the current line */
+void gui_context_expand_add(WindowGui *window, const char *text);
+/* first lines of the buffer are about to be removed, forget the cut
+   texts in them */
+void gui_context_expand_trim(WindowGui *window, int lines);
+
+void gui_context_expand_init(void);
+void gui_context_expand_deinit(void);
+
+#endif
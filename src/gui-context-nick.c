@@ -24,45 +24,55 @@
 #include "channels.h"
 #include "nicklist.h"
 
+#include "gui-charset.h"
+#include "gui-scan.h"
 #include "gui-frame.h"
 #include "gui-tab.h"
 #include "gui-window.h"
 #include "gui-window-view.h"
 #include "gui-window-context.h"
+#include "gui-nick-colors.h"
+#include "gui-nicklist.h"
 #include "gui-nicklist-view.h"
 #include "gui-menu.h"
 
 #define STATUSBAR_CONTEXT "context nick"
 
-static void statusbar_push_nick(GtkStatusbar *statusbar, Nick *nick)
+static GString *status_text; /* reused, hovering shouldn't malloc */
+
+static void status_append(const char *label, const char *value,
+			  const char *charset)
 {
-	unsigned int id;
-	GString *str;
 	char *text;
 
-	id = gtk_statusbar_get_context_id(statusbar, STATUSBAR_CONTEXT);
+	g_string_append(status_text, label);
+	if (gui_scan_utf8_validate(value, strlen(value))) {
+		g_string_append(status_text, value);
+		return;
+	}
+
+	text = gui_charset_to_utf8(charset, value);
+	g_string_append(status_text, text);
+	g_free(text);
+}
+
+static void statusbar_push_nick(GtkStatusbar *statusbar, Nick *nick,
+				const char *charset)
+{
+	unsigned int id;
 
-	str = g_string_new(NULL);
-	g_string_sprintfa(str, "Nick: %s", nick->nick);
+	id = gtk_statusbar_get_context_id(statusbar, STATUSBAR_CONTEXT);
 
+	/* each value separately, the labels are already UTF-8 */
+	g_string_truncate(status_text, 0);
+	status_append("Nick: ", nick->nick, charset);
 	if (nick->host != NULL)
-		g_string_sprintfa(str, "  -  Host: %s", nick->host);
+		status_append("  -  Host: ", nick->host, charset);
 	if (nick->realname != NULL)
-		g_string_sprintfa(str, "  -  Name: %s", nick->realname);
-
-	/* this really should be done separately to all the nick->* values,
-	   at least when we add i18n support to strings above.. */
-	text = g_locale_to_utf8(str->str, -1, NULL, NULL, NULL);
-	if (text == NULL) {
-		text = g_convert(str->str, str->len, "UTF-8", "CP1252",
-				 NULL, NULL, NULL);
-	}
+		status_append("  -  Name: ", nick->realname, charset);
 
 	gtk_statusbar_pop(statusbar, id);
-	gtk_statusbar_push(statusbar, id, text != NULL ? text : str->str);
-
-	g_free(text);
-	g_string_free(str, TRUE);
+	gtk_statusbar_push(statusbar, id, status_text->str);
 }
 
 static void statusbar_pop_nick(GtkStatusbar *statusbar)
@@ -100,7 +110,8 @@ static Nick *nick_find_first(Server *server, const char *nick)
 }
 
 static void sig_window_word(GtkTextTag **tag, WindowGui *window,
-			    Channel *channel, const char *word)
+			    Channel *channel, const char *word,
+			    GtkTextTag **style)
 {
 	char *name;
 
@@ -114,11 +125,12 @@ static void sig_window_word(GtkTextTag **tag, WindowGui *window,
 		return;
 
 	/* yeah, it's a nick */
-	name = g_strconcat("nick ", channel->server->tag, NULL);
+	name = gui_arena_strconcat(window->arena, "nick ",
+				   channel->server->tag, NULL);
 	*tag = gtk_text_tag_table_lookup(window->tagtable, name);
 	if (*tag == NULL)
 		*tag = gui_window_context_create_tag(window, name);
-	g_free(name);
+	*style = gui_nick_color_tag(word);
 
 	signal_stop();
 }
@@ -126,13 +138,18 @@ static void sig_window_word(GtkTextTag **tag, WindowGui *window,
 static void sig_window_enter(Window *window, const char *word, GtkTextTag *tag)
 {
 	Server *server;
+	Channel *channel;
 	Nick *nick;
 
 	server = tag_get_server(tag);
 	if (server != NULL) {
 		nick = nick_find_first(server, word);
-		if (nick != NULL)
-			statusbar_push_nick(active_frame->statusbar, nick);
+		channel = CHANNEL(window->active);
+		if (nick != NULL) {
+			statusbar_push_nick(active_frame->statusbar, nick,
+					    gui_charset_find(server, channel == NULL ?
+							     NULL : channel->name));
+		}
 	}
 }
 
@@ -193,7 +210,11 @@ static void sig_window_press(Window *window, const char *word,
 
 static void sig_nicklist_enter(NicklistView *view, Nick *nick)
 {
-	statusbar_push_nick(view->tab->frame->statusbar, nick);
+	Channel *channel;
+
+	channel = view->nicklist->channel;
+	statusbar_push_nick(view->tab->frame->statusbar, nick,
+			    gui_charset_find(channel->server, channel->name));
 }
 
 static void sig_nicklist_leave(NicklistView *view, Nick *nick)
@@ -203,6 +224,8 @@ static void sig_nicklist_leave(NicklistView *view, Nick *nick)
 
 void gui_context_nick_init(void)
 {
+	status_text = g_string_new(NULL);
+
         signal_add("gui window context word", (SIGNAL_FUNC) sig_window_word);
         signal_add("gui window context enter", (SIGNAL_FUNC) sig_window_enter);
         signal_add("gui window context leave", (SIGNAL_FUNC) sig_window_leave);
@@ -213,6 +236,8 @@ void gui_context_nick_init(void)
 
 void gui_context_nick_deinit(void)
 {
+	g_string_free(status_text, TRUE);
+
         signal_remove("gui window context word", (SIGNAL_FUNC) sig_window_word);
         signal_remove("gui window context enter", (SIGNAL_FUNC) sig_window_enter);
         signal_remove("gui window context leave", (SIGNAL_FUNC) sig_window_leave);
@@ -22,10 +22,13 @@
 
 #include "keyboard.h"
 
+#include "gui-burst.h"
 #include "gui-frame.h"
+#include "gui-history-search.h"
 #include "gui-entry.h"
 #include "gui-itemlist.h"
 #include "gui-keyboard.h"
+#include "gui-paste.h"
 #include "gui-tab.h"
 #include "gui-window.h"
 #include "gui-windowlist.h"
@@ -48,6 +51,7 @@ static gboolean event_destroy(GtkWidget *window, Frame *frame)
 	gtk_widget_destroy(GTK_WIDGET(frame->notebook));
 
 	signal_emit("gui frame destroyed", 1, frame);
+	gui_burst_cancel(frame);
 	g_object_set_data(G_OBJECT(frame->widget), "Frame", NULL);
 	g_free(frame);
 
@@ -91,10 +95,11 @@ static void entry_grab_focus(GtkWidget *entry, GdkEventKey *event)
 static gboolean event_key_press(GtkWidget *widget, GdkEventKey *event,
 				Frame *frame)
 {
-	char *str;
+	GtkWidget *focus;
 
-	if (g_slist_find(frame->focusable_widgets,
-			 gtk_window_get_focus(frame->window)) != NULL) {
+	focus = gtk_window_get_focus(frame->window);
+	if (focus != NULL &&
+	    g_object_get_data(G_OBJECT(focus), "focusable_frame") == frame) {
 		/* focus is in another widget where it's allowed -
 		   don't do anything */
 		return FALSE;
@@ -108,19 +113,21 @@ static gboolean event_key_press(GtkWidget *widget, GdkEventKey *event,
 		return FALSE;
 	}
 
+	if (gui_history_search_key(frame->entry, event) ||
+	    gui_paste_key(frame, event)) {
+		g_signal_stop_emission_by_name(G_OBJECT(widget),
+					       "key_press_event");
+		return TRUE;
+	}
+
 	if (frame->entry->last_dead_key) {
 		/* we're continuing a dead key press, so the keycode is still
 		   incomplete. don't try to handle any custom key bindings */
 		frame->entry->last_dead_key = FALSE;
-	} else {
-		str = gui_keyboard_get_event_string(event);
-		if (key_pressed(frame->entry->keyboard, str) >= 0) {
-			g_signal_stop_emission_by_name(G_OBJECT(widget),
-						       "key_press_event");
-			g_free(str);
-			return TRUE;
-		}
-		g_free(str);
+	} else if (gui_keyboard_dispatch(frame->entry->keyboard, event)) {
+		g_signal_stop_emission_by_name(G_OBJECT(widget),
+					       "key_press_event");
+		return TRUE;
 	}
 
 	entry_grab_focus(frame->entry->widget, event);
@@ -136,11 +143,14 @@ static gboolean event_switch_page(GtkWidget *notebook, GtkNotebookPage *page,
 	if (tab != NULL) {
 		gtk_widget_modify_bg(tab->tab_label_widget, GTK_STATE_NORMAL,
 				     &notebook->style->bg[GTK_STATE_ACTIVE]);
+		gui_tab_set_visible(tab, FALSE);
 	}
+	frame->prev_tab = tab;
 
 	tab = gui_tab_get_page(frame, page_num);
 	gtk_widget_modify_bg(tab->tab_label_widget, GTK_STATE_NORMAL,
 			     &notebook->style->bg[GTK_STATE_NORMAL]);
+	gui_tab_set_visible(tab, TRUE);
 
 	frame->active_tab = tab;
 	if (tab->active_win != NULL)
@@ -231,14 +241,12 @@ Frame *gui_frame_new(int show)
 
 void gui_frame_add_focusable_widget(Frame *frame, GtkWidget *widget)
 {
-	frame->focusable_widgets =
-		g_slist_prepend(frame->focusable_widgets, widget);
+	g_object_set_data(G_OBJECT(widget), "focusable_frame", frame);
 }
 
 void gui_frame_remove_focusable_widget(Frame *frame, GtkWidget *widget)
 {
-	frame->focusable_widgets =
-		g_slist_remove(frame->focusable_widgets, widget);
+	g_object_set_data(G_OBJECT(widget), "focusable_frame", NULL);
 }
 
 void gui_frame_set_active(Frame *frame)
@@ -13,9 +13,8 @@ struct _Frame {
 	Entry *entry;
 	Itemlist *itemlist;
 
-	GSList *focusable_widgets;
-
 	Tab *active_tab;
+	Tab *prev_tab; /* tab that was active before active_tab */
 
 	WindowList *winlist;
 
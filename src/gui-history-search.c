@@ -0,0 +1,391 @@
+/*
+ gui-history-search.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+
+#include "gui-entry.h"
+#include "gui-frame.h"
+#include "gui-history-search.h"
+
+#include <gdk/gdkkeysyms.h>
+
+#define STATUSBAR_CONTEXT "history search"
+
+#define TRIGRAM(p) \
+	(((guint32) (guchar) (p)[0] << 16) | \
+	 ((guint32) (guchar) (p)[1] << 8) | (guchar) (p)[2])
+
+typedef struct {
+	char *text;
+	char *folded; /* lowercased text, what the index is built from */
+	Window *window; /* NULL if the window is gone */
+} HistoryLine;
+
+typedef struct {
+	Entry *entry;
+
+	GString *query;
+	char *orig_text; /* restored if search is aborted */
+
+	int pos; /* index of the current match in lines, -1 = none */
+	unsigned int global:1;
+	unsigned int failing:1;
+} HistorySearch;
+
+static GPtrArray *lines; /* HistoryLine, oldest first */
+static GHashTable *trigrams; /* trigram => GArray of line indexes */
+
+static void index_add_line(int pos)
+{
+	HistoryLine *line;
+	GArray *list;
+	const char *p;
+	guint32 key;
+
+	line = g_ptr_array_index(lines, pos);
+	for (p = line->folded; p[0] != '\0' && p[1] != '\0' && p[2] != '\0'; p++) {
+		key = TRIGRAM(p);
+		list = g_hash_table_lookup(trigrams, GUINT_TO_POINTER(key));
+		if (list == NULL) {
+			list = g_array_new(FALSE, FALSE, sizeof(int));
+			g_hash_table_insert(trigrams, GUINT_TO_POINTER(key),
+					    list);
+		}
+
+		/* each line only once per trigram */
+		if (list->len == 0 ||
+		    g_array_index(list, int, list->len-1) != pos)
+			g_array_append_val(list, pos);
+	}
+}
+
+static int trigram_list_free(gpointer key, GArray *list)
+{
+	g_array_free(list, TRUE);
+	return TRUE;
+}
+
+static void history_line_free(HistoryLine *line)
+{
+	g_free(line->text);
+	g_free(line->folded);
+	g_free(line);
+}
+
+/* drop the oldest half of the lines and rebuild the index */
+static void index_shrink(void)
+{
+	GPtrArray *old;
+	int i, count;
+
+	old = lines;
+	count = old->len / 2;
+	lines = g_ptr_array_sized_new(old->len);
+	for (i = 0; i < (int)old->len; i++) {
+		if (i < count)
+			history_line_free(g_ptr_array_index(old, i));
+		else
+			g_ptr_array_add(lines, g_ptr_array_index(old, i));
+	}
+	g_ptr_array_free(old, TRUE);
+
+	g_hash_table_foreach_remove(trigrams, (GHRFunc) trigram_list_free,
+				    NULL);
+	for (i = 0; i < (int)lines->len; i++)
+		index_add_line(i);
+}
+
+void gui_history_search_add(Window *window, const char *text)
+{
+	HistoryLine *line;
+	int max;
+
+	max = settings_get_int("history_search_max_lines");
+	if (max > 0 && (int)lines->len >= max)
+		index_shrink();
+
+	line = g_new0(HistoryLine, 1);
+	line->text = g_strdup(text);
+	line->folded = g_ascii_strdown(text, -1);
+	line->window = window;
+	g_ptr_array_add(lines, line);
+
+	index_add_line(lines->len-1);
+}
+
+static int line_matches(HistoryLine *line, const char *folded, Window *window)
+{
+	if (window != NULL && line->window != window)
+		return FALSE;
+	return strstr(line->folded, folded) != NULL;
+}
+
+/* Find the newest line before pos containing query. If window is
+   non-NULL, only lines written in it are searched. */
+static int index_find(const char *query, int pos, Window *window)
+{
+	GArray *list, *best;
+	const char *p;
+	char *folded;
+	int i, found;
+
+	folded = g_ascii_strdown(query, -1);
+	found = -1;
+
+	if (strlen(folded) < 3) {
+		/* too short for the index */
+		for (i = pos-1; i >= 0; i--) {
+			if (line_matches(g_ptr_array_index(lines, i),
+					 folded, window)) {
+				found = i;
+				break;
+			}
+		}
+		g_free(folded);
+		return found;
+	}
+
+	/* the rarest trigram of the query gives the fewest candidates */
+	best = NULL;
+	for (p = folded; p[2] != '\0'; p++) {
+		list = g_hash_table_lookup(trigrams,
+					   GUINT_TO_POINTER(TRIGRAM(p)));
+		if (list == NULL) {
+			best = NULL;
+			break;
+		}
+		if (best == NULL || list->len < best->len)
+			best = list;
+	}
+
+	for (i = best == NULL ? -1 : (int)best->len-1; i >= 0; i--) {
+		int line = g_array_index(best, int, i);
+
+		if (line < pos &&
+		    line_matches(g_ptr_array_index(lines, line),
+				 folded, window)) {
+			found = line;
+			break;
+		}
+	}
+
+	g_free(folded);
+	return found;
+}
+
+static void search_update(HistorySearch *search, int from)
+{
+	GtkStatusbar *statusbar;
+	HistoryLine *line;
+	Frame *frame;
+	unsigned int id;
+	char *str;
+	int pos;
+
+	pos = -1;
+	if (search->query->len > 0) {
+		pos = index_find(search->query->str, from,
+				 search->global ? NULL :
+				 search->entry->active_win);
+	}
+
+	search->failing = pos < 0 && search->query->len > 0;
+	if (pos >= 0) {
+		search->pos = pos;
+		line = g_ptr_array_index(lines, pos);
+		gtk_entry_set_text(search->entry->entry, line->text);
+		gtk_editable_set_position(GTK_EDITABLE(search->entry->entry),
+					  -1);
+	}
+
+	frame = gui_widget_find_data(search->entry->widget, "Frame");
+	if (frame == NULL)
+		return;
+
+	statusbar = frame->statusbar;
+	id = gtk_statusbar_get_context_id(statusbar, STATUSBAR_CONTEXT);
+	str = g_strdup_printf("%sreverse-i-search (%s): `%s'",
+			      search->failing ? "failing " : "",
+			      search->global ? "all windows" : "this window",
+			      search->query->str);
+	gtk_statusbar_pop(statusbar, id);
+	gtk_statusbar_push(statusbar, id, str);
+	g_free(str);
+}
+
+static void search_destroy(HistorySearch *search)
+{
+	Frame *frame;
+	unsigned int id;
+
+	g_object_set_data(G_OBJECT(search->entry->widget),
+			  "HistorySearch", NULL);
+
+	frame = gui_widget_find_data(search->entry->widget, "Frame");
+	if (frame != NULL) {
+		id = gtk_statusbar_get_context_id(frame->statusbar,
+						  STATUSBAR_CONTEXT);
+		gtk_statusbar_pop(frame->statusbar, id);
+	}
+
+	g_string_free(search->query, TRUE);
+	g_free(search->orig_text);
+	g_free(search);
+}
+
+static void search_abort(HistorySearch *search)
+{
+	gtk_entry_set_text(search->entry->entry, search->orig_text);
+	gtk_editable_set_position(GTK_EDITABLE(search->entry->entry), -1);
+	search_destroy(search);
+}
+
+void gui_history_search_start(Entry *entry)
+{
+	HistorySearch *search;
+
+	search = g_object_get_data(G_OBJECT(entry->widget), "HistorySearch");
+	if (search != NULL) {
+		/* ^R again - continue to older matches */
+		search_update(search, search->pos < 0 ? (int)lines->len :
+			      search->pos);
+		return;
+	}
+
+	search = g_new0(HistorySearch, 1);
+	search->entry = entry;
+	search->query = g_string_new(NULL);
+	search->orig_text = g_strdup(gtk_entry_get_text(entry->entry));
+	search->pos = -1;
+	search->global = settings_get_bool("history_search_global");
+	g_object_set_data(G_OBJECT(entry->widget), "HistorySearch", search);
+
+	search_update(search, lines->len);
+}
+
+int gui_history_search_key(Entry *entry, GdkEventKey *event)
+{
+	HistorySearch *search;
+	gunichar chr;
+	char buf[7];
+	int len;
+
+	search = g_object_get_data(G_OBJECT(entry->widget), "HistorySearch");
+	if (search == NULL)
+		return FALSE;
+
+	if (event->state & GDK_CONTROL_MASK) {
+		switch (event->keyval) {
+		case GDK_r:
+		case GDK_R:
+			gui_history_search_start(entry);
+			return TRUE;
+		case GDK_g:
+		case GDK_G:
+			search_abort(search);
+			return TRUE;
+		}
+	}
+
+	switch (event->keyval) {
+	case GDK_Escape:
+		search_abort(search);
+		return TRUE;
+	case GDK_Tab:
+		search->global = !search->global;
+		search_update(search, lines->len);
+		return TRUE;
+	case GDK_BackSpace:
+		if (search->query->len > 0) {
+			len = g_utf8_prev_char(search->query->str +
+					       search->query->len) -
+				search->query->str;
+			g_string_truncate(search->query, len);
+		}
+		search_update(search, lines->len);
+		return TRUE;
+	}
+
+	if ((event->state & (GDK_CONTROL_MASK | GDK_MOD1_MASK)) == 0) {
+		chr = gdk_keyval_to_unicode(event->keyval);
+		if (chr >= 32) {
+			buf[g_unichar_to_utf8(chr, buf)] = '\0';
+			g_string_append(search->query, buf);
+			search_update(search, lines->len);
+			return TRUE;
+		}
+	}
+
+	/* anything else accepts the match and is handled normally */
+	search_destroy(search);
+	return FALSE;
+}
+
+static void sig_window_destroyed(Window *window)
+{
+	int i;
+
+	for (i = 0; i < (int)lines->len; i++) {
+		HistoryLine *line = g_ptr_array_index(lines, i);
+
+		if (line->window == window)
+			line->window = NULL;
+	}
+}
+
+static void sig_entry_destroyed(Entry *entry)
+{
+	HistorySearch *search;
+
+	search = g_object_get_data(G_OBJECT(entry->widget), "HistorySearch");
+	if (search != NULL)
+		search_destroy(search);
+}
+
+void gui_history_search_init(void)
+{
+	lines = g_ptr_array_new();
+	trigrams = g_hash_table_new((GHashFunc) g_direct_hash,
+				    (GCompareFunc) g_direct_equal);
+
+	settings_add_bool("history", "history_search_global", FALSE);
+	settings_add_int("history", "history_search_max_lines", 50000);
+
+	signal_add("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_add("gui entry destroyed", (SIGNAL_FUNC) sig_entry_destroyed);
+}
+
+void gui_history_search_deinit(void)
+{
+	int i;
+
+	g_hash_table_foreach_remove(trigrams, (GHRFunc) trigram_list_free,
+				    NULL);
+	g_hash_table_destroy(trigrams);
+
+	for (i = 0; i < (int)lines->len; i++)
+		history_line_free(g_ptr_array_index(lines, i));
+	g_ptr_array_free(lines, TRUE);
+
+	signal_remove("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_remove("gui entry destroyed", (SIGNAL_FUNC) sig_entry_destroyed);
+}
@@ -0,0 +1,17 @@
+#ifndef __GUI_HISTORY_SEARCH_H
+#define __GUI_HISTORY_SEARCH_H
+
+/* Add a line sent from window to the search index */
+void gui_history_search_add(Window *window, const char *text);
+
+/* Start incremental reverse search in entry, or find the next older
+   match if it's already searching. */
+void gui_history_search_start(Entry *entry);
+/* Handle a key press while searching. Returns TRUE if the key was
+   used by the search. */
+int gui_history_search_key(Entry *entry, GdkEventKey *event);
+
+void gui_history_search_init(void);
+void gui_history_search_deinit(void);
+
+#endif
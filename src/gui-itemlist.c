@@ -18,248 +18,267 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
-#undef GTK_DISABLE_DEPRECATED
-
 #include "module.h"
 #include "signals.h"
 #include "servers.h"
 
 #include "window-items.h"
 
+#include "gui-burst.h"
 #include "gui-frame.h"
 #include "gui-tab.h"
 #include "gui-window.h"
 #include "gui-window-view.h"
 #include "gui-itemlist.h"
 
+/* Window => GtkListStore of its items */
+static GHashTable *window_stores;
+/* WindowItem or Server => GtkTreeIter in its store */
+static GHashTable *rows;
+static GtkListStore *server_store;
+
 static gboolean event_destroy(GtkWidget *widget, Itemlist *itemlist)
 {
-	if (itemlist->short_menu != NULL) {
-		gtk_widget_unref(itemlist->short_menu);
-		gtk_widget_unref(itemlist->long_menu);
-	}
+	if (itemlist->tab_store != NULL)
+		g_object_unref(G_OBJECT(itemlist->tab_store));
 	g_free(itemlist);
 	return FALSE;
 }
 
-static gboolean event_button_press(GtkWidget *widget, GdkEventButton *event,
-				   Itemlist *itemlist)
+static char *witem_get_name(WindowItem *witem, int long_view)
 {
-	if (event->type != GDK_BUTTON_PRESS || event->button != 1)
-		return FALSE;
-	gtk_option_menu_set_menu(itemlist->menu, itemlist->long_menu);
-	return FALSE;
+	return witem->server == NULL || !long_view ?
+		g_strdup(witem->visible_name) :
+		g_strdup_printf("%s (%s)", witem->visible_name,
+				witem->server->tag);
 }
 
-static gboolean event_selection_done(GtkWidget *widget, Itemlist *itemlist)
+static char *server_get_name(Server *server, int long_view)
 {
+	return !long_view ? g_strdup(server->tag) :
+		g_strdup_printf("%s (%s:%d)", server->tag,
+				server->connrec->address,
+				server->connrec->port);
+}
+
+static void item_label_func(GtkCellLayout *layout, GtkCellRenderer *cell,
+			    GtkTreeModel *model, GtkTreeIter *iter,
+			    Itemlist *itemlist)
+{
+	void *data;
+	char *str;
+
+	gtk_tree_model_get(model, iter, 0, &data, -1);
+	str = itemlist->window_items ?
+		witem_get_name(data, itemlist->long_view) :
+		server_get_name(data, itemlist->long_view);
+	g_object_set(G_OBJECT(cell), "text", str, NULL);
+	g_free(str);
+}
+
+static void event_popup_shown(GtkComboBox *combo, GParamSpec *pspec,
+			      Itemlist *itemlist)
+{
+	gboolean shown;
+
+	/* names are longer in the popup */
+	g_object_get(G_OBJECT(combo), "popup-shown", &shown, NULL);
+	itemlist->long_view = shown;
+}
+
+static void event_changed(GtkComboBox *combo, Itemlist *itemlist)
+{
+	GtkTreeIter iter;
 	Window *window;
 	WindowItem *witem;
 	Server *server;
-	int index;
 
-	index = gtk_option_menu_get_history(itemlist->menu);
-	gtk_option_menu_set_menu(itemlist->menu, itemlist->short_menu);
-	gtk_option_menu_set_history(itemlist->menu, index);
+	if (!gtk_combo_box_get_active_iter(combo, &iter))
+		return;
 
 	if (itemlist->window_items) {
-		window = g_slist_nth_data(itemlist->items, index*2);
-		if (g_slist_find(windows, window) == NULL)
-			return FALSE;
-
-		witem = g_slist_nth_data(itemlist->items, index*2 + 1);
-		if (g_slist_find(window->items, witem) == NULL)
-			return FALSE;
+		gtk_tree_model_get(gtk_combo_box_get_model(combo), &iter,
+				   0, &witem, -1);
+		window = window_item_window(witem);
 
 		window_set_active(window);
 		window_item_set_active(window, witem);
 	} else {
-		window = itemlist->frame->active_tab->active_win;
-
-		server = g_slist_nth_data(itemlist->items, index);
-		if (g_slist_find(servers, server) != NULL)
-			window_change_server(window, server);
+		gtk_tree_model_get(gtk_combo_box_get_model(combo), &iter,
+				   0, &server, -1);
+		window_change_server(itemlist->window, server);
 	}
-
-	return FALSE;
 }
 
 Itemlist *gui_itemlist_new(Frame *frame)
 {
 	Itemlist *itemlist;
+	GtkCellRenderer *renderer;
 
 	itemlist = g_new0(Itemlist, 1);
 	itemlist->frame = frame;
 
-	itemlist->widget = gtk_option_menu_new();
-	itemlist->menu = GTK_OPTION_MENU(itemlist->widget);
-	g_signal_connect(G_OBJECT(itemlist->menu), "destroy",
+	itemlist->widget = gtk_combo_box_new();
+	itemlist->combo = GTK_COMBO_BOX(itemlist->widget);
+	gtk_combo_box_set_focus_on_click(itemlist->combo, FALSE);
+
+	renderer = gtk_cell_renderer_text_new();
+	gtk_cell_layout_pack_start(GTK_CELL_LAYOUT(itemlist->combo),
+				   renderer, TRUE);
+	gtk_cell_layout_set_cell_data_func(GTK_CELL_LAYOUT(itemlist->combo),
+					   renderer,
+					   (GtkCellLayoutDataFunc) item_label_func,
+					   itemlist, NULL);
+
+	g_signal_connect(G_OBJECT(itemlist->combo), "destroy",
 			 G_CALLBACK(event_destroy), itemlist);
-	g_signal_connect(G_OBJECT(itemlist->menu), "button_press_event",
-			 G_CALLBACK(event_button_press), itemlist);
+	g_signal_connect(G_OBJECT(itemlist->combo), "notify::popup-shown",
+			 G_CALLBACK(event_popup_shown), itemlist);
+	itemlist->changed_sig =
+		g_signal_connect(G_OBJECT(itemlist->combo), "changed",
+				 G_CALLBACK(event_changed), itemlist);
 
 	return itemlist;
 }
 
-static char *witem_get_name(WindowItem *witem, int long_view)
+static int tab_store_find(GtkListStore *store, void *data, GtkTreeIter *iter)
 {
-	return witem->server == NULL || !long_view ?
-		g_strdup(witem->visible_name) :
-		g_strdup_printf("%s (%s)", witem->visible_name,
-				witem->server->tag);
-}
+	GtkTreeModel *model;
+	void *row;
 
-static char *server_get_name(Server *server, int long_view)
-{
-	return !long_view ? g_strdup(server->tag) :
-		g_strdup_printf("%s (%s:%d)", server->tag,
-				server->connrec->address,
-				server->connrec->port);
+	model = GTK_TREE_MODEL(store);
+	if (!gtk_tree_model_get_iter_first(model, iter))
+		return FALSE;
+
+	do {
+		gtk_tree_model_get(model, iter, 0, &row, -1);
+		if (row == data)
+			return TRUE;
+	} while (gtk_tree_model_iter_next(model, iter));
+
+	return FALSE;
 }
 
-static void add_window_items(Window *window, Itemlist *itemlist)
+static void gui_itemlist_set_active(Itemlist *itemlist, Window *window)
 {
-	GtkMenuShell *short_menu, *long_menu;
-	GtkWidget *item;
-	GSList *tmp;
-	char *str;
+	GtkTreeIter *iter, tab_iter;
+	void *active;
 
-	short_menu = GTK_MENU_SHELL(itemlist->short_menu);
-	long_menu = GTK_MENU_SHELL(itemlist->long_menu);
+	active = itemlist->window_items ? (void *) window->active :
+		(void *) window->active_server;
 
-	for (tmp = window->items; tmp != NULL; tmp = tmp->next) {
-		WindowItem *witem = tmp->data;
-
-		/* short */
-		str = witem_get_name(witem, FALSE);
-		item = gtk_menu_item_new_with_label(str);
-		gtk_menu_shell_append(short_menu, item);
-		g_free(str);
-
-		/* long */
-		str = witem_get_name(witem, TRUE);
-		item = gtk_menu_item_new_with_label(str);
-		gtk_menu_shell_append(long_menu, item);
-		g_free(str);
-
-		itemlist->items = g_slist_append(itemlist->items, window);
-		itemlist->items = g_slist_append(itemlist->items, witem);
+	if (itemlist->window_items && itemlist->tab_store != NULL) {
+		iter = tab_store_find(itemlist->tab_store, active,
+				      &tab_iter) ? &tab_iter : NULL;
+	} else {
+		iter = g_hash_table_lookup(rows, active);
 	}
+
+	g_signal_handler_block(G_OBJECT(itemlist->combo), itemlist->changed_sig);
+	if (iter != NULL)
+		gtk_combo_box_set_active_iter(itemlist->combo, iter);
+	else
+		gtk_combo_box_set_active(itemlist->combo, -1);
+	g_signal_handler_unblock(G_OBJECT(itemlist->combo), itemlist->changed_sig);
 }
 
-static void add_server_items(Itemlist *itemlist)
+static void tab_store_add(GtkListStore *store, Window *window)
 {
-	GtkMenuShell *short_menu, *long_menu;
-	GtkWidget *item;
+	GtkTreeIter iter;
 	GSList *tmp;
-	char *str;
 
-	short_menu = GTK_MENU_SHELL(itemlist->short_menu);
-	long_menu = GTK_MENU_SHELL(itemlist->long_menu);
-
-	for (tmp = servers; tmp != NULL; tmp = tmp->next) {
-		Server *server = tmp->data;
-
-		/* short */
-		str = server_get_name(server, FALSE);
-		item = gtk_menu_item_new_with_label(str);
-		gtk_menu_shell_append(short_menu, item);
-		g_free(str);
-
-		/* long */
-		str = server_get_name(server, TRUE);
-		item = gtk_menu_item_new_with_label(str);
-		gtk_menu_shell_append(long_menu, item);
-		g_free(str);
-
-		itemlist->items = g_slist_append(itemlist->items, server);
+	for (tmp = window->items; tmp != NULL; tmp = tmp->next) {
+		gtk_list_store_append(store, &iter);
+		gtk_list_store_set(store, &iter, 0, tmp->data, -1);
 	}
 }
 
-static void gui_itemlist_update_items(Itemlist *itemlist, Window *window)
+/* Items of the other split panes in the active tab are listed after the
+   window's own ones. Returns FALSE if no other pane has any items. */
+static int gui_itemlist_fill_tab_store(Itemlist *itemlist, Window *window)
 {
+	Tab *tab;
 	GList *tmp;
-
-	if (window->items == NULL && servers == NULL) {
-		/* nothing - hide the itemlist */
-		gtk_widget_hide(itemlist->widget);
-		return;
+	int others;
+
+	tab = itemlist->frame->active_tab;
+	others = FALSE;
+	for (tmp = tab == NULL ? NULL : tab->panes; tmp != NULL; tmp = tmp->next) {
+		TabPane *pane = tmp->data;
+
+		if (pane->view != NULL &&
+		    pane->view->window->window != window &&
+		    pane->view->window->window->items != NULL) {
+			others = TRUE;
+			break;
+		}
 	}
 
-	if (itemlist->short_menu != NULL) {
-		gtk_widget_unref(itemlist->short_menu);
-		gtk_widget_unref(itemlist->long_menu);
+	if (!others) {
+		if (itemlist->tab_store != NULL) {
+			g_object_unref(G_OBJECT(itemlist->tab_store));
+			itemlist->tab_store = NULL;
+		}
+		return FALSE;
 	}
 
-	itemlist->short_menu = gtk_menu_new();
-	itemlist->long_menu = gtk_menu_new();
-	gtk_widget_ref(itemlist->short_menu);
-	gtk_widget_ref(itemlist->long_menu);
-
-	g_signal_connect(G_OBJECT(itemlist->long_menu), "selection_done",
-			 G_CALLBACK(event_selection_done), itemlist);
+	if (itemlist->tab_store == NULL)
+		itemlist->tab_store = gtk_list_store_new(1, G_TYPE_POINTER);
+	else
+		gtk_list_store_clear(itemlist->tab_store);
 
-	g_slist_free(itemlist->items);
-	itemlist->items = NULL;
+	tab_store_add(itemlist->tab_store, window);
+	for (tmp = tab->panes; tmp != NULL; tmp = tmp->next) {
+		TabPane *pane = tmp->data;
 
-	if (window->items != NULL) {
-		/* update items list from window items */
-		itemlist->window_items = TRUE;
+		if (pane->view != NULL &&
+		    pane->view->window->window != window)
+			tab_store_add(itemlist->tab_store,
+				      pane->view->window->window);
+	}
+	return TRUE;
+}
 
-		/* add items in active window */
-		add_window_items(window, itemlist);
+static void gui_itemlist_set_window(Itemlist *itemlist, Window *window)
+{
+	GtkTreeModel *model;
 
-		/* add items in other views in active tab */
-                tmp = itemlist->frame->active_tab->panes;
-		for (; tmp != NULL; tmp = tmp->next) {
-			TabPane *pane = tmp->data;
+	itemlist->window = window;
+	itemlist->window_items = window->items != NULL;
 
-			if (pane->view != NULL &&
-			    pane->view->window->window != window) {
-				add_window_items(pane->view->window->window,
-						 itemlist);
-			}
+	g_signal_handler_block(G_OBJECT(itemlist->combo), itemlist->changed_sig);
+	if (window->items == NULL) {
+		if (itemlist->tab_store != NULL) {
+			g_object_unref(G_OBJECT(itemlist->tab_store));
+			itemlist->tab_store = NULL;
 		}
+		model = GTK_TREE_MODEL(server_store);
+	} else if (gui_itemlist_fill_tab_store(itemlist, window)) {
+		model = GTK_TREE_MODEL(itemlist->tab_store);
 	} else {
-		/* no window items - servers then */
-		itemlist->window_items = FALSE;
-		add_server_items(itemlist);
+		model = GTK_TREE_MODEL(g_hash_table_lookup(window_stores,
+							   window));
 	}
 
-	gtk_widget_show_all(itemlist->short_menu);
-	gtk_widget_show_all(itemlist->long_menu);
+	if (gtk_combo_box_get_model(itemlist->combo) != model)
+		gtk_combo_box_set_model(itemlist->combo, model);
+	g_signal_handler_unblock(G_OBJECT(itemlist->combo), itemlist->changed_sig);
 
-	gtk_option_menu_set_menu(itemlist->menu, itemlist->short_menu);
+	gui_itemlist_set_active(itemlist, window);
 
-	if (itemlist->items->next == NULL ||
-	    (window->items && itemlist->items->next->next == NULL)) {
-		/* only one item, hide */
+	if (gtk_tree_model_iter_n_children(model, NULL) <= 1) {
+		/* nothing or only one item, hide */
 		gtk_widget_hide(itemlist->widget);
 	} else {
 		gtk_widget_show(itemlist->widget);
 	}
 }
 
-static void gui_itemlist_set_active(Itemlist *itemlist, Window *window)
+static void frame_itemlist_refresh(Frame *frame)
 {
-	int index;
-
-	index = -1;
-	if (itemlist->window_items) {
-		if (window->active != NULL) {
-			index = g_slist_index(itemlist->items, window->active);
-			if (index != -1)
-				index /= 2;
-		}
-	} else {
-		if (window->active_server != NULL) {
-			index = g_slist_index(itemlist->items,
-					      window->active_server);
-		}
-	}
-
-	if (index != -1)
-                gtk_option_menu_set_history(itemlist->menu, index);
+	if (frame->active_tab != NULL && frame->active_tab->active_win != NULL)
+		gui_itemlist_set_window(frame->itemlist,
+					frame->active_tab->active_win);
 }
 
 static void gui_itemlist_update_window(Window *window, int update_items)
@@ -270,14 +289,118 @@ static void gui_itemlist_update_window(Window *window, int update_items)
 		WindowView *view = tmp->data;
 		Tab *tab = view->pane->tab;
 
-		if (tab->frame->active_tab != tab)
+		if (tab->frame->active_tab != tab || tab->active_win == NULL)
+			continue;
+
+		if (tab->active_win != window) {
+			/* another split pane, only its items are listed */
+			if (!update_items ||
+			    !tab->frame->itemlist->window_items)
+				continue;
+		}
+
+		if (gui_burst_defer((GuiBurstFunc) frame_itemlist_refresh,
+				    tab->frame))
 			continue;
 
-		/* update selection */
 		if (update_items)
-			gui_itemlist_update_items(tab->frame->itemlist, window);
-		gui_itemlist_set_active(tab->frame->itemlist, window);
+			gui_itemlist_set_window(tab->frame->itemlist,
+						tab->active_win);
+		else
+			gui_itemlist_set_active(tab->frame->itemlist, window);
+	}
+}
+
+static void row_add(GtkListStore *store, void *data)
+{
+	GtkTreeIter *iter;
+
+	iter = g_new(GtkTreeIter, 1);
+	gtk_list_store_append(store, iter);
+	gtk_list_store_set(store, iter, 0, data, -1);
+	g_hash_table_insert(rows, data, iter);
+}
+
+static void row_remove(GtkListStore *store, void *data)
+{
+	GtkTreeIter *iter;
+
+	iter = g_hash_table_lookup(rows, data);
+	if (iter == NULL)
+		return;
+
+	g_hash_table_remove(rows, data);
+	gtk_list_store_remove(store, iter);
+	g_free(iter);
+}
+
+static void row_changed(GtkListStore *store, void *data)
+{
+	GtkTreeIter *iter;
+	GtkTreePath *path;
+
+	iter = g_hash_table_lookup(rows, data);
+	if (iter == NULL)
+		return;
+
+	path = gtk_tree_model_get_path(GTK_TREE_MODEL(store), iter);
+	gtk_tree_model_row_changed(GTK_TREE_MODEL(store), path, iter);
+	gtk_tree_path_free(path);
+}
+
+static void tab_stores_changed(void *data)
+{
+	GtkTreeIter iter;
+	GtkTreePath *path;
+	GSList *tmp;
+
+	for (tmp = frames; tmp != NULL; tmp = tmp->next) {
+		Frame *frame = tmp->data;
+		GtkListStore *store = frame->itemlist->tab_store;
+
+		if (store == NULL || !tab_store_find(store, data, &iter))
+			continue;
+
+		path = gtk_tree_model_get_path(GTK_TREE_MODEL(store), &iter);
+		gtk_tree_model_row_changed(GTK_TREE_MODEL(store), path, &iter);
+		gtk_tree_path_free(path);
+	}
+}
+
+static void sig_window_created(Window *window)
+{
+	g_hash_table_insert(window_stores, window,
+			    gtk_list_store_new(1, G_TYPE_POINTER));
+}
+
+static void sig_window_destroyed(Window *window)
+{
+	GtkListStore *store;
+	GSList *tmp;
+
+	store = g_hash_table_lookup(window_stores, window);
+	if (store == NULL)
+		return;
+
+	for (tmp = window->items; tmp != NULL; tmp = tmp->next)
+		row_remove(store, tmp->data);
+
+	for (tmp = frames; tmp != NULL; tmp = tmp->next) {
+		Frame *frame = tmp->data;
+
+		if (frame->itemlist->window == window) {
+			frame->itemlist->window = NULL;
+			gtk_combo_box_set_model(frame->itemlist->combo, NULL);
+			if (frame->itemlist->tab_store != NULL) {
+				g_object_unref(G_OBJECT(frame->itemlist->tab_store));
+				frame->itemlist->tab_store = NULL;
+			}
+			gtk_widget_hide(frame->itemlist->widget);
+		}
 	}
+
+	g_hash_table_remove(window_stores, window);
+	g_object_unref(G_OBJECT(store));
 }
 
 static void sig_window_changed(Window *window)
@@ -285,9 +408,31 @@ static void sig_window_changed(Window *window)
 	gui_itemlist_update_window(window, TRUE);
 }
 
+static void sig_window_item_new(Window *window, WindowItem *witem)
+{
+	row_add(g_hash_table_lookup(window_stores, window), witem);
+	gui_itemlist_update_window(window, TRUE);
+}
+
+static void sig_window_item_remove(Window *window, WindowItem *witem)
+{
+	row_remove(g_hash_table_lookup(window_stores, window), witem);
+	gui_itemlist_update_window(window, TRUE);
+}
+
 static void sig_window_item_name_changed(WindowItem *witem)
 {
-	gui_itemlist_update_window(window_item_window(witem), TRUE);
+	Window *window;
+
+	window = window_item_window(witem);
+	row_changed(g_hash_table_lookup(window_stores, window), witem);
+	tab_stores_changed(witem);
+}
+
+static void sig_window_item_server_changed(Window *window, WindowItem *witem)
+{
+	row_changed(g_hash_table_lookup(window_stores, window), witem);
+	tab_stores_changed(witem);
 }
 
 static void sig_window_item_changed(Window *window)
@@ -300,32 +445,98 @@ static void sig_server_connected(Server *server)
 {
 	GSList *tmp;
 
-	for (tmp = windows; tmp != NULL; tmp = tmp->next) {
-		Window *window = tmp->data;
+	row_add(server_store, server);
+
+	for (tmp = frames; tmp != NULL; tmp = tmp->next) {
+		Frame *frame = tmp->data;
 
-		if (window->active_server == server)
-			sig_window_changed(window);
+		if (frame->itemlist->window != NULL &&
+		    !frame->itemlist->window_items)
+			gui_itemlist_set_window(frame->itemlist,
+						frame->itemlist->window);
+	}
+}
+
+static void sig_server_disconnected(Server *server)
+{
+	GSList *tmp;
+
+	row_remove(server_store, server);
+
+	for (tmp = frames; tmp != NULL; tmp = tmp->next) {
+		Frame *frame = tmp->data;
+
+		if (frame->itemlist->window != NULL &&
+		    !frame->itemlist->window_items)
+			gui_itemlist_set_window(frame->itemlist,
+						frame->itemlist->window);
 	}
 }
 
 void gui_itemlists_init(void)
 {
+	GSList *tmp, *sub;
+
+	window_stores = g_hash_table_new((GHashFunc) g_direct_hash,
+					 (GCompareFunc) g_direct_equal);
+	rows = g_hash_table_new((GHashFunc) g_direct_hash,
+				(GCompareFunc) g_direct_equal);
+	server_store = gtk_list_store_new(1, G_TYPE_POINTER);
+
+	for (tmp = servers; tmp != NULL; tmp = tmp->next)
+		row_add(server_store, tmp->data);
+	for (tmp = windows; tmp != NULL; tmp = tmp->next) {
+		Window *window = tmp->data;
+
+		sig_window_created(window);
+		for (sub = window->items; sub != NULL; sub = sub->next) {
+			row_add(g_hash_table_lookup(window_stores, window),
+				sub->data);
+		}
+	}
+
+	signal_add("window created", (SIGNAL_FUNC) sig_window_created);
+	signal_add("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
 	signal_add("window changed", (SIGNAL_FUNC) sig_window_changed);
-	signal_add("window item new", (SIGNAL_FUNC) sig_window_changed);
-	signal_add("window item remove", (SIGNAL_FUNC) sig_window_changed);
+	signal_add("window item new", (SIGNAL_FUNC) sig_window_item_new);
+	signal_add("window item remove", (SIGNAL_FUNC) sig_window_item_remove);
 	signal_add("window item name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_add("window item server changed", (SIGNAL_FUNC) sig_window_item_server_changed);
 	signal_add("window item changed", (SIGNAL_FUNC) sig_window_item_changed);
 	signal_add("window server changed", (SIGNAL_FUNC) sig_window_item_changed);
 	signal_add("server connected", (SIGNAL_FUNC) sig_server_connected);
+	signal_add("server disconnected", (SIGNAL_FUNC) sig_server_disconnected);
+}
+
+static int store_free(Window *window, GtkListStore *store)
+{
+	g_object_unref(G_OBJECT(store));
+	return TRUE;
+}
+
+static int row_free(void *data, GtkTreeIter *iter)
+{
+	g_free(iter);
+	return TRUE;
 }
 
 void gui_itemlists_deinit(void)
 {
+	g_hash_table_foreach_remove(rows, (GHRFunc) row_free, NULL);
+	g_hash_table_destroy(rows);
+	g_hash_table_foreach_remove(window_stores, (GHRFunc) store_free, NULL);
+	g_hash_table_destroy(window_stores);
+	g_object_unref(G_OBJECT(server_store));
+
+	signal_remove("window created", (SIGNAL_FUNC) sig_window_created);
+	signal_remove("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
 	signal_remove("window changed", (SIGNAL_FUNC) sig_window_changed);
-	signal_remove("window item new", (SIGNAL_FUNC) sig_window_changed);
-	signal_remove("window item remove", (SIGNAL_FUNC) sig_window_changed);
+	signal_remove("window item new", (SIGNAL_FUNC) sig_window_item_new);
+	signal_remove("window item remove", (SIGNAL_FUNC) sig_window_item_remove);
 	signal_remove("window item name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_remove("window item server changed", (SIGNAL_FUNC) sig_window_item_server_changed);
 	signal_remove("window item changed", (SIGNAL_FUNC) sig_window_item_changed);
 	signal_remove("window server changed", (SIGNAL_FUNC) sig_window_item_changed);
 	signal_remove("server connected", (SIGNAL_FUNC) sig_server_connected);
+	signal_remove("server disconnected", (SIGNAL_FUNC) sig_server_disconnected);
 }
@@ -5,12 +5,16 @@ struct _Itemlist {
 	Frame *frame;
 
 	GtkWidget *widget;
-	GtkWidget *short_menu, *long_menu;
-	GtkOptionMenu *menu;
+	GtkComboBox *combo;
+	gulong changed_sig;
 
-	GSList *items;
+	Window *window; /* whose items or servers are shown */
+	/* items of all windows in a split tab, NULL when only one
+	   window has items and its own store is used */
+	GtkListStore *tab_store;
 
 	unsigned int window_items:1;
+	unsigned int long_view:1;
 };
 
 Itemlist *gui_itemlist_new(Frame *frame);
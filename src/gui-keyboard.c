@@ -23,20 +23,52 @@
 #include "misc.h"
 #include "special-vars.h"
 #include "servers.h"
+#include "levels.h"
+#include "printtext.h"
 
 #include "keyboard.h"
 #include "completion.h"
 #include "command-history.h"
 
+#include "gui-charset.h"
 #include "gui-keyboard.h"
 #include "gui-entry.h"
+#include "gui-completion.h"
+#include "gui-history-search.h"
 #include "gui-frame.h"
 #include "gui-tab.h"
 #include "gui-window.h"
 #include "gui-window-view.h"
+#include "gui-window-switcher.h"
+#include "gui-paste.h"
 
 #include <gdk/gdkkeysyms.h>
 
+/* the modifiers gui_keyboard_get_event_string() looks at */
+#define KEY_STATE_MASK \
+	(GDK_SHIFT_MASK | GDK_CONTROL_MASK | GDK_MOD1_MASK | GDK_MOD4_MASK)
+
+/* forget the cached key strings after this many different keys */
+#define MAX_KEY_EVENTS 512
+
+typedef struct {
+	guint keyval, state;
+	char *str;
+
+	unsigned int bound_stamp; /* bindings_stamp when bound was set */
+	unsigned int bound:1;
+} KeyEvent;
+
+static GHashTable *key_events; /* KeyEvent => KeyEvent */
+static GHashTable *bound_keys; /* bound key strings and their prefixes */
+static unsigned int bindings_stamp;
+static int bound_keys_dirty;
+
+static struct {
+	unsigned long keys, dispatched;
+	long usecs, max_usecs;
+} key_stats;
+
 char *gui_keyboard_get_event_string(GdkEventKey *event)
 {
 	GString *cmd;
@@ -95,6 +127,147 @@ char *gui_keyboard_get_event_string(GdkEventKey *event)
 	return ret;
 }
 
+static guint key_event_hash(const KeyEvent *rec)
+{
+	return rec->keyval ^ (rec->state << 24);
+}
+
+static gint key_event_equal(const KeyEvent *rec1, const KeyEvent *rec2)
+{
+	return rec1->keyval == rec2->keyval && rec1->state == rec2->state;
+}
+
+static int key_event_free(KeyEvent *rec)
+{
+	g_free(rec->str);
+	g_free(rec);
+	return TRUE;
+}
+
+static void bound_key_add(const char *key)
+{
+	const char *p;
+
+	if (key == NULL || *key == '\0' ||
+	    g_hash_table_lookup(bound_keys, key) != NULL)
+		return;
+
+	/* combos are sent to key_pressed() one key at a time, so the
+	   first keys of them need to be handled too. this adds a few
+	   useless prefixes like "meta", but that doesn't matter. */
+	for (p = strchr(key+1, '-'); p != NULL; p = strchr(p+1, '-')) {
+		char *prefix = g_strndup(key, (int) (p-key));
+
+		if (g_hash_table_lookup(bound_keys, prefix) == NULL)
+			g_hash_table_insert(bound_keys, prefix, prefix);
+		else
+			g_free(prefix);
+	}
+	g_hash_table_insert(bound_keys, g_strdup(key), GINT_TO_POINTER(1));
+}
+
+static int bound_key_free(char *key)
+{
+	g_free(key);
+	return TRUE;
+}
+
+static void bound_keys_rebuild(void)
+{
+	GSList *tmp, *sub;
+
+	g_hash_table_foreach_remove(bound_keys, (GHRFunc) bound_key_free, NULL);
+	for (tmp = keyinfos; tmp != NULL; tmp = tmp->next) {
+		KeyAction *info = tmp->data;
+
+		for (sub = info->keys; sub != NULL; sub = sub->next) {
+			Key *key = sub->data;
+
+			bound_key_add(key->key);
+		}
+	}
+	bound_keys_dirty = FALSE;
+}
+
+static KeyEvent *key_event_get(GdkEventKey *event)
+{
+	KeyEvent search, *rec;
+
+	search.keyval = event->keyval;
+	search.state = event->state & KEY_STATE_MASK;
+
+	rec = g_hash_table_lookup(key_events, &search);
+	if (rec == NULL) {
+		if (g_hash_table_size(key_events) >= MAX_KEY_EVENTS) {
+			g_hash_table_foreach_remove(key_events,
+						    (GHRFunc) key_event_free,
+						    NULL);
+		}
+
+		rec = g_new0(KeyEvent, 1);
+		rec->keyval = search.keyval;
+		rec->state = search.state;
+		rec->str = gui_keyboard_get_event_string(event);
+		rec->bound_stamp = bindings_stamp-1;
+		g_hash_table_insert(key_events, rec, rec);
+	}
+
+	if (rec->bound_stamp != bindings_stamp) {
+		if (bound_keys_dirty)
+			bound_keys_rebuild();
+		rec->bound = g_hash_table_lookup(bound_keys, rec->str) != NULL;
+		rec->bound_stamp = bindings_stamp;
+	}
+	return rec;
+}
+
+int gui_keyboard_dispatch(Keyboard *keyboard, GdkEventKey *event)
+{
+	GTimeVal start, end;
+	KeyEvent *rec;
+	long usecs;
+	int ret;
+
+	g_get_current_time(&start);
+
+	rec = key_event_get(event);
+	if (!rec->bound && keyboard->key_state == NULL) {
+		/* not bound and not continuing a combo */
+		ret = FALSE;
+	} else {
+		key_stats.dispatched++;
+		ret = key_pressed(keyboard, rec->str) >= 0;
+	}
+
+	g_get_current_time(&end);
+	usecs = (end.tv_sec - start.tv_sec) * G_USEC_PER_SEC +
+		(end.tv_usec - start.tv_usec);
+
+	key_stats.keys++;
+	key_stats.usecs += usecs;
+	if (usecs > key_stats.max_usecs)
+		key_stats.max_usecs = usecs;
+	return ret;
+}
+
+static void sig_key_changed(void)
+{
+	bindings_stamp++;
+	bound_keys_dirty = TRUE;
+}
+
+static void sig_gui_stats(Window *window)
+{
+	printtext_window(window, MSGLEVEL_CLIENTCRAP,
+			 "Keyboard: %lu keys, %lu sent to key_pressed(), "
+			 "%u cached key strings, %ld usecs average, "
+			 "%ld usecs max", key_stats.keys, key_stats.dispatched,
+			 g_hash_table_size(key_events),
+			 key_stats.keys == 0 ? 0 :
+			 key_stats.usecs / (long) key_stats.keys,
+			 key_stats.max_usecs);
+}
+
 int gui_is_modifier(int keyval)
 {
 	switch (keyval) {
@@ -264,6 +437,11 @@ static void key_forward_history(const char *data, Entry *entry)
 	gtk_editable_set_position(GTK_EDITABLE(entry->entry), len);
 }
 
+static void key_history_search(const char *data, Entry *entry)
+{
+	gui_history_search_start(entry);
+}
+
 static void key_backspace(const char *data, Entry *entry)
 {
 	g_signal_emit_by_name(G_OBJECT(entry->entry), "delete_from_cursor",
@@ -359,8 +537,9 @@ static void key_transpose_characters(const char *data, Entry *entry)
 static void key_send_line(const char *data, Entry *entry)
 {
 	HISTORY_REC *history;
-	const char *line;
-	char *str, *next, *add_history;
+	WindowItem *item;
+	const char *line, *charset;
+	char *str, *add_history;
 
 	line = gtk_entry_get_text(entry->entry);
 	if (line == NULL || *line == '\0')
@@ -371,37 +550,23 @@ static void key_send_line(const char *data, Entry *entry)
 	add_history = g_strdup(line);
 	history = command_history_current(entry->active_win);
 
-	str = g_locale_from_utf8(line, -1, NULL, NULL, NULL);
-	if (str == NULL) {
-		/* error - fallback to utf8 */
-		str = g_strdup(line);
-	}
+	/* falls back to utf8 if it can't be converted */
+	item = entry->active_win->active;
+	charset = gui_charset_find(entry->active_win->active_server,
+				   item == NULL ? NULL : item->visible_name);
+	str = gui_charset_from_utf8(charset, line);
 
 	gtk_widget_ref(entry->widget);
 
-	/* str may contain \r or \n chars, split the line from there */
-	do {
-		for (next = str; ; next++) {
-			if (*next == '\0' || *next == '\r' || *next == '\n')
-				break;
-		}
-
-		if (*next == '\0')
-			next = NULL;
-		else
-			*next++ = '\0';
-
-		signal_emit("send command", 3, str,
-			    entry->active_win->active_server,
-			    entry->active_win->active);
-
-		str = next;
-	} while (str != NULL);
+	/* str may contain \r or \n chars, large pastes are throttled */
+	gui_paste_send(gui_widget_find_data(entry->widget, "Frame"),
+		       entry->active_win, str);
 
 	if (add_history != NULL) {
 		history = command_history_find(history);
 		if (history != NULL)
 			command_history_add(history, add_history);
+		gui_history_search_add(entry->active_win, add_history);
                 g_free(add_history);
 	}
 
@@ -413,16 +578,25 @@ static void key_send_line(const char *data, Entry *entry)
         g_free(str);
 }
 
-static void key_completion(Entry *entry, int erase)
+static void key_paste_cancel(const char *data, Entry *entry)
+{
+	gui_paste_cancel(gui_widget_find_data(entry->widget, "Frame"));
+}
+
+static void key_completion(Entry *entry, int erase, int backward)
 {
 	const char *text;
 	char *line;
 	int pos;
 
+	/* nicks are completed from our own index */
+	if (!erase && gui_completion_complete(entry, backward))
+		return;
+
 	pos = gtk_editable_get_position(GTK_EDITABLE(entry->entry));
 
         text = gtk_entry_get_text(entry->entry);
-	line = word_complete(entry->active_win, text, &pos, erase, FALSE);
+	line = word_complete(entry->active_win, text, &pos, erase, backward);
 
 	if (line != NULL) {
 		gtk_entry_set_text(entry->entry, line);
@@ -433,12 +607,17 @@ static void key_completion(Entry *entry, int erase)
 
 static void key_word_completion(const char *data, Entry *entry)
 {
-        key_completion(entry, FALSE);
+        key_completion(entry, FALSE, FALSE);
+}
+
+static void key_backward_word_completion(const char *data, Entry *entry)
+{
+        key_completion(entry, FALSE, TRUE);
 }
 
 static void key_erase_completion(const char *data, Entry *entry)
 {
-        key_completion(entry, TRUE);
+        key_completion(entry, TRUE, FALSE);
 }
 
 static void key_check_replaces(const char *data, Entry *entry)
@@ -616,6 +795,8 @@ static void key_scroll(Entry *entry, int pos)
 
 	gui = WINDOW_GUI(entry->active_win);
 	view = gui->active_view;
+	if (view->view == NULL)
+		return;
 
 	switch (pos) {
 	case KEY_SCROLL_START:
@@ -686,12 +867,32 @@ static void key_change_tab(const char *data, Entry *entry)
 	gtk_notebook_set_current_page(frame->notebook, atoi(data)-1);
 }
 
+static void key_window_switcher(const char *data, Entry *entry)
+{
+	Frame *frame;
+
+	frame = gui_widget_find_data(entry->widget, "Frame");
+	gui_window_switcher_open(frame);
+}
+
 void gui_keyboards_init(void)
 {
 	static char changekeys[] = "1234567890qwertyuio";
 	char key[20], data[MAX_INT_STRLEN];
 	int i;
 
+	key_events = g_hash_table_new((GHashFunc) key_event_hash,
+				      (GCompareFunc) key_event_equal);
+	bound_keys = g_hash_table_new((GHashFunc) g_str_hash,
+				      (GCompareFunc) g_str_equal);
+	bindings_stamp = 0;
+	bound_keys_dirty = TRUE;
+	memset(&key_stats, 0, sizeof(key_stats));
+
+	signal_add("key created", (SIGNAL_FUNC) sig_key_changed);
+	signal_add("key destroyed", (SIGNAL_FUNC) sig_key_changed);
+	signal_add("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+
 	key_configure_freeze();
 
 	/* cursor movement */
@@ -711,6 +912,7 @@ void gui_keyboards_init(void)
         /* history */
 	key_bind("backward_history", "", "up", NULL, (SIGNAL_FUNC) key_backward_history);
 	key_bind("forward_history", "", "down", NULL, (SIGNAL_FUNC) key_forward_history);
+	key_bind("history_search", "Incremental reverse search of the command history", "^R", NULL, (SIGNAL_FUNC) key_history_search);
 
         /* line editing */
 	key_bind("backspace", "", "backspace", NULL, (SIGNAL_FUNC) key_backspace);
@@ -729,8 +931,10 @@ void gui_keyboards_init(void)
         /* line transmitting */
 	key_bind("send_line", "Execute the input line", "return", NULL, (SIGNAL_FUNC) key_send_line);
 	key_bind("word_completion", "", "tab", NULL, (SIGNAL_FUNC) key_word_completion);
+	key_bind("backward_word_completion", "", "shift-iso_left_tab", NULL, (SIGNAL_FUNC) key_backward_word_completion);
 	key_bind("erase_completion", "", "meta-k", NULL, (SIGNAL_FUNC) key_erase_completion);
 	key_bind("check_replaces", "Check word replaces", NULL, NULL, (SIGNAL_FUNC) key_check_replaces);
+	key_bind("paste_cancel", "Stop sending a paste", NULL, NULL, (SIGNAL_FUNC) key_paste_cancel);
 
         /* window managing */
 	key_bind("previous_window", "Previous window", NULL, NULL, (SIGNAL_FUNC) key_previous_window);
@@ -755,7 +959,6 @@ void gui_keyboards_init(void)
 	key_bind("insert_text", NULL, "^B", "\\002", (SIGNAL_FUNC) key_insert_text);
 	key_bind("insert_text", NULL, "^K", "\\003", (SIGNAL_FUNC) key_insert_text);
 	key_bind("insert_text", NULL, "^O", "\\017", (SIGNAL_FUNC) key_insert_text);
-	key_bind("insert_text", NULL, "^R", "\\026", (SIGNAL_FUNC) key_insert_text);
 	key_bind("insert_text", NULL, "^-", "\\037", (SIGNAL_FUNC) key_insert_text);
 
         /* autoreplaces */
@@ -769,6 +972,7 @@ void gui_keyboards_init(void)
 		ltoa(data, i+1);
 		key_bind("change_tab", "Change tab", key, data, (SIGNAL_FUNC) key_change_tab);
 	}
+	key_bind("window_switcher", "Search windows by name", "meta-s", NULL, (SIGNAL_FUNC) key_window_switcher);
         key_configure_thaw();
 }
 
@@ -785,6 +989,7 @@ void gui_keyboards_deinit(void)
 
 	key_unbind("backward_history", (SIGNAL_FUNC) key_backward_history);
 	key_unbind("forward_history", (SIGNAL_FUNC) key_forward_history);
+	key_unbind("history_search", (SIGNAL_FUNC) key_history_search);
 
 	key_unbind("backspace", (SIGNAL_FUNC) key_backspace);
 	key_unbind("delete_character", (SIGNAL_FUNC) key_delete_character);
@@ -800,6 +1005,7 @@ void gui_keyboards_deinit(void)
 
 	key_unbind("send_line", (SIGNAL_FUNC) key_send_line);
 	key_unbind("word_completion", (SIGNAL_FUNC) key_word_completion);
+	key_unbind("backward_word_completion", (SIGNAL_FUNC) key_backward_word_completion);
 	key_unbind("erase_completion", (SIGNAL_FUNC) key_erase_completion);
 	key_unbind("check_replaces", (SIGNAL_FUNC) key_check_replaces);
 
@@ -824,4 +1030,15 @@ void gui_keyboards_deinit(void)
 
 	key_unbind("change_window", (SIGNAL_FUNC) key_change_window);
 	key_unbind("change_tab", (SIGNAL_FUNC) key_change_tab);
+	key_unbind("window_switcher", (SIGNAL_FUNC) key_window_switcher);
+	key_unbind("paste_cancel", (SIGNAL_FUNC) key_paste_cancel);
+
+	signal_remove("key created", (SIGNAL_FUNC) sig_key_changed);
+	signal_remove("key destroyed", (SIGNAL_FUNC) sig_key_changed);
+	signal_remove("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+
+	g_hash_table_foreach_remove(key_events, (GHRFunc) key_event_free, NULL);
+	g_hash_table_destroy(key_events);
+	g_hash_table_foreach_remove(bound_keys, (GHRFunc) bound_key_free, NULL);
+	g_hash_table_destroy(bound_keys);
 }
@@ -2,6 +2,8 @@
 #define __GUI_KEYBOARD_H
 
 char *gui_keyboard_get_event_string(GdkEventKey *event);
+/* Run the key binding for event. Returns TRUE if the key was bound. */
+int gui_keyboard_dispatch(Keyboard *keyboard, GdkEventKey *event);
 
 int gui_is_modifier(int keyval);
 int gui_is_dead_key(int keyval);
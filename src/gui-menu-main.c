@@ -96,7 +96,8 @@ static void menu_callback(void *user_data, const char *item_data, int action)
 			gtk_widget_show(GTK_WIDGET(active_frame->statusbar));
 		break;
 	case ACTION_VIEW_NICKLIST:
-		if (active_frame->active_tab->nicklist->nicklist == NULL)
+		if (active_frame->active_tab->nicklist == NULL ||
+		    active_frame->active_tab->nicklist->nicklist == NULL)
 			break;
 
 		widget = active_frame->active_tab->nicklist->widget;
@@ -0,0 +1,152 @@
+/*
+ gui-nick-colors.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+
+#include "gui-nick-colors.h"
+#include "gui-style.h"
+
+#define DEFAULT_PALETTE \
+	"#cc0000 #00a000 #b58900 #0055dd #aa00aa #008b8b #d75f00 " \
+	"#5f5fff #5f8700 #af005f #0087af #875fd7"
+
+static int enabled;
+static GPtrArray *palette; /* GtkTextTag, indexed by the nick hash */
+static GHashTable *overrides; /* lowercased nick => GtkTextTag */
+
+/* same nick gets the same color everywhere and every time */
+static unsigned int nick_hash(const char *nick)
+{
+	unsigned int hash;
+
+	for (hash = 5381; *nick != '\0'; nick++)
+		hash = hash * 33 + g_ascii_tolower(*nick);
+	return hash;
+}
+
+/* one tag per color, shared by the palette and the overrides */
+static GtkTextTag *color_tag_get(const char *color)
+{
+	GtkTextTagTable *table;
+	GtkTextTag *tag;
+	GdkColor gdkcolor;
+	char *name;
+
+	if (!gdk_color_parse(color, &gdkcolor))
+		return NULL;
+
+	table = gui_style_tag_table();
+	name = g_strconcat("nickcolor ", color, NULL);
+	tag = gtk_text_tag_table_lookup(table, name);
+	if (tag == NULL) {
+		tag = gtk_text_tag_new(name);
+		g_object_set(G_OBJECT(tag), "foreground-gdk", &gdkcolor, NULL);
+		gtk_text_tag_table_add(table, tag);
+		g_object_unref(G_OBJECT(tag));
+	}
+	g_free(name);
+	return tag;
+}
+
+GtkTextTag *gui_nick_color_tag(const char *nick)
+{
+	GtkTextTag *tag;
+	char *key;
+
+	if (!enabled || palette->len == 0)
+		return NULL;
+
+	if (g_hash_table_size(overrides) > 0) {
+		key = g_ascii_strdown(nick, -1);
+		tag = g_hash_table_lookup(overrides, key);
+		g_free(key);
+		if (tag != NULL)
+			return tag;
+	}
+
+	return g_ptr_array_index(palette, nick_hash(nick) % palette->len);
+}
+
+static int override_remove(char *key, void *value)
+{
+	g_free(key);
+	return TRUE;
+}
+
+static void read_settings(void)
+{
+	GtkTextTag *tag;
+	char **list, **tmp, *p;
+
+	enabled = settings_get_bool("gui_nick_colors");
+
+	g_ptr_array_set_size(palette, 0);
+	list = g_strsplit(settings_get_str("gui_nick_color_palette"), " ", -1);
+	for (tmp = list; *tmp != NULL; tmp++) {
+		tag = **tmp == '\0' ? NULL : color_tag_get(*tmp);
+		if (tag != NULL)
+			g_ptr_array_add(palette, tag);
+	}
+	g_strfreev(list);
+
+	/* "nick=color nick2=color2" */
+	g_hash_table_foreach_remove(overrides, (GHRFunc) override_remove, NULL);
+	list = g_strsplit(settings_get_str("gui_nick_color_overrides"), " ", -1);
+	for (tmp = list; *tmp != NULL; tmp++) {
+		p = strchr(*tmp, '=');
+		if (p == NULL || p == *tmp)
+			continue;
+
+		*p++ = '\0';
+		tag = color_tag_get(p);
+		if (tag != NULL) {
+			g_hash_table_insert(overrides,
+					    g_ascii_strdown(*tmp, -1), tag);
+		}
+	}
+	g_strfreev(list);
+}
+
+void gui_nick_colors_init(void)
+{
+	palette = g_ptr_array_new();
+	overrides = g_hash_table_new((GHashFunc) g_str_hash,
+				     (GCompareFunc) g_str_equal);
+
+	settings_add_bool("lookandfeel", "gui_nick_colors", FALSE);
+	settings_add_str("lookandfeel", "gui_nick_color_palette",
+			 DEFAULT_PALETTE);
+	settings_add_str("lookandfeel", "gui_nick_color_overrides", "");
+	read_settings();
+
+	signal_add("setup changed", (SIGNAL_FUNC) read_settings);
+}
+
+void gui_nick_colors_deinit(void)
+{
+	g_hash_table_foreach_remove(overrides, (GHRFunc) override_remove, NULL);
+	g_hash_table_destroy(overrides);
+	g_ptr_array_free(palette, TRUE);
+
+	signal_remove("setup changed", (SIGNAL_FUNC) read_settings);
+}
@@ -0,0 +1,12 @@
+#ifndef __GUI_NICK_COLORS_H
+#define __GUI_NICK_COLORS_H
+
+/* Returns the tag coloring nick, or NULL if nick colors are disabled.
+   The color comes from a hash of the nick, unless it's overridden in
+   gui_nick_color_overrides. */
+GtkTextTag *gui_nick_color_tag(const char *nick);
+
+void gui_nick_colors_init(void);
+void gui_nick_colors_deinit(void);
+
+#endif
@@ -28,6 +28,7 @@
 #include "gui-channel.h"
 #include "gui-nicklist.h"
 #include "gui-nicklist-view.h"
+#include "gui-scheduler.h"
 
 static gint nicklist_sort_func(GtkTreeModel *model,
 			       GtkTreeIter *a, GtkTreeIter *b,
@@ -75,6 +76,7 @@ Nicklist *gui_nicklist_new(Channel *channel)
 void gui_nicklist_destroy(Nicklist *nicklist)
 {
 	signal_emit("gui nicklist destroyed", 1, nicklist);
+	gui_scheduler_cancel(nicklist);
 
 	while (nicklist->views != NULL) {
 		NicklistView *view = nicklist->views->data;
@@ -86,7 +88,7 @@ void gui_nicklist_destroy(Nicklist *nicklist)
 	g_free(nicklist);
 }
 
-static void gui_nicklist_update_label(Nicklist *nicklist)
+static void nicklist_set_label(Nicklist *nicklist)
 {
 	GSList *tmp;
 	char label[128];
@@ -101,6 +103,15 @@ static void gui_nicklist_update_label(Nicklist *nicklist)
 	}
 }
 
+/* joins and mode changes come in bunches, update the label once */
+static void gui_nicklist_update_label(Nicklist *nicklist)
+{
+	if (nicklist->views != NULL) {
+		gui_scheduler_add(GUI_JOB_VISIBLE,
+				  (GuiJobFunc) nicklist_set_label, nicklist);
+	}
+}
+
 static void gui_nicklist_add(Channel *channel, Nick *nick, int update_label)
 {
 	ChannelGui *gui;
@@ -0,0 +1,368 @@
+/*
+ gui-paste.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+#include "servers.h"
+#include "levels.h"
+
+#include "printtext.h"
+
+#include "gui-frame.h"
+#include "gui-paste.h"
+#include "gui-scan.h"
+
+#include <gdk/gdkkeysyms.h>
+
+#define STATUSBAR_CONTEXT "paste"
+/* pastes with fewer lines are sent right away, without the delay */
+#define PASTE_IMMEDIATE_LINES 5
+
+typedef struct {
+	Frame *frame;
+	Window *window;
+	Server *server;
+	WindowItem *item;
+
+	GtkWidget *dialog;
+	int timeout_tag;
+
+	char **lines;
+	int count, pos;
+} Paste;
+
+static GSList *pastes;
+
+static void paste_statusbar_pop(Paste *paste)
+{
+	unsigned int id;
+
+	if (paste->frame == NULL)
+		return;
+
+	id = gtk_statusbar_get_context_id(paste->frame->statusbar,
+					  STATUSBAR_CONTEXT);
+	gtk_statusbar_pop(paste->frame->statusbar, id);
+}
+
+static void paste_statusbar_update(Paste *paste)
+{
+	unsigned int id;
+	char *str;
+
+	if (paste->frame == NULL)
+		return;
+
+	id = gtk_statusbar_get_context_id(paste->frame->statusbar,
+					  STATUSBAR_CONTEXT);
+	str = g_strdup_printf("Pasting to %s: %d/%d lines (Esc cancels)",
+			      paste->item != NULL ? paste->item->visible_name :
+			      paste->window->name != NULL ?
+			      paste->window->name : "window",
+			      paste->pos, paste->count);
+
+	gtk_statusbar_pop(paste->frame->statusbar, id);
+	gtk_statusbar_push(paste->frame->statusbar, id, str);
+	g_free(str);
+}
+
+static void paste_destroy(Paste *paste)
+{
+	GtkWidget *dialog;
+
+	pastes = g_slist_remove(pastes, paste);
+
+	if (paste->timeout_tag != -1)
+		g_source_remove(paste->timeout_tag);
+
+	if (paste->dialog != NULL) {
+		dialog = paste->dialog;
+		paste->dialog = NULL;
+		gtk_widget_destroy(dialog);
+	}
+
+	paste_statusbar_pop(paste);
+
+	if (paste->server != NULL)
+		server_unref(paste->server);
+	g_strfreev(paste->lines);
+	g_free(paste);
+}
+
+static void paste_cancel(Paste *paste)
+{
+	if (paste->dialog == NULL) {
+		printtext_window(paste->window, MSGLEVEL_CLIENTNOTICE,
+				 "Paste cancelled, %d of %d lines were sent",
+				 paste->pos, paste->count);
+	}
+	paste_destroy(paste);
+}
+
+/* Returns FALSE if the command destroyed the paste */
+static int paste_send_line(Paste *paste)
+{
+	const char *line;
+
+	line = paste->lines[paste->pos++];
+	signal_emit("send command", 3, line, paste->server, paste->item);
+
+	return g_slist_find(pastes, paste) != NULL;
+}
+
+static gboolean paste_timeout(Paste *paste)
+{
+	if (!paste_send_line(paste))
+		return FALSE;
+
+	if (paste->pos == paste->count) {
+		paste->timeout_tag = -1;
+		paste_destroy(paste);
+		return FALSE;
+	}
+
+	paste_statusbar_update(paste);
+	return TRUE;
+}
+
+static void paste_start(Paste *paste)
+{
+	int delay;
+
+	delay = settings_get_int("paste_line_delay");
+	if (delay < 10)
+		delay = 10;
+
+	/* first line right away */
+	if (!paste_send_line(paste))
+		return;
+	paste_statusbar_update(paste);
+
+	paste->timeout_tag = g_timeout_add(delay, (GSourceFunc) paste_timeout,
+					   paste);
+}
+
+static void event_response(GtkWidget *dialog, int response_id, Paste *paste)
+{
+	paste->dialog = NULL;
+	gtk_widget_destroy(dialog);
+
+	if (response_id == GTK_RESPONSE_YES)
+		paste_start(paste);
+	else
+		paste_destroy(paste);
+}
+
+static void event_dialog_destroy(GtkWidget *dialog, Paste *paste)
+{
+	/* closed without answering */
+	if (paste->dialog != NULL) {
+		paste->dialog = NULL;
+		paste_destroy(paste);
+	}
+}
+
+/* Split text to lines from \r, \n and \r\n. The last line is dropped
+   if it's empty. */
+static char **paste_split_lines(const char *text, int *count)
+{
+	GPtrArray *lines;
+	const char *p, *end;
+
+	lines = g_ptr_array_new();
+	end = text + strlen(text);
+	for (;;) {
+		p = text + gui_scan_eol(text, (int) (end-text));
+
+		if (*p == '\0') {
+			if (p != text || lines->len == 0)
+				g_ptr_array_add(lines, g_strdup(text));
+			break;
+		}
+
+		g_ptr_array_add(lines, g_strndup(text, (int) (p-text)));
+		if (p[0] == '\r' && p[1] == '\n')
+			p++;
+		text = p+1;
+	}
+
+	*count = lines->len;
+	g_ptr_array_add(lines, NULL);
+	return (char **) g_ptr_array_free(lines, FALSE);
+}
+
+void gui_paste_send(Frame *frame, Window *window, const char *text)
+{
+	Paste *paste;
+	char **lines;
+	int i, count, verify;
+
+	lines = paste_split_lines(text, &count);
+
+	if (count < PASTE_IMMEDIATE_LINES) {
+		/* small enough to send right away */
+		for (i = 0; i < count; i++) {
+			signal_emit("send command", 3, lines[i],
+				    window->active_server, window->active);
+		}
+		g_strfreev(lines);
+		return;
+	}
+
+	paste = g_new0(Paste, 1);
+	paste->frame = frame;
+	paste->window = window;
+	paste->server = window->active_server;
+	paste->item = window->active;
+	paste->lines = lines;
+	paste->count = count;
+	paste->timeout_tag = -1;
+	if (paste->server != NULL)
+		server_ref(paste->server);
+	pastes = g_slist_prepend(pastes, paste);
+
+	verify = settings_get_int("paste_verify_line_count");
+	if (verify <= 0 || count < verify) {
+		/* no need to ask, but still send it slowly */
+		paste_start(paste);
+		return;
+	}
+
+	paste->dialog = gtk_message_dialog_new(frame->window,
+					       GTK_DIALOG_DESTROY_WITH_PARENT,
+					       GTK_MESSAGE_QUESTION,
+					       GTK_BUTTONS_YES_NO,
+					       "Paste %d lines to %s?", count,
+					       paste->item != NULL ?
+					       paste->item->visible_name :
+					       "this window");
+	gtk_dialog_set_default_response(GTK_DIALOG(paste->dialog),
+					GTK_RESPONSE_NO);
+	g_signal_connect(G_OBJECT(paste->dialog), "response",
+			 G_CALLBACK(event_response), paste);
+	g_signal_connect(G_OBJECT(paste->dialog), "destroy",
+			 G_CALLBACK(event_dialog_destroy), paste);
+	gtk_widget_show(paste->dialog);
+}
+
+int gui_paste_cancel(Frame *frame)
+{
+	GSList *tmp, *next;
+	int found;
+
+	found = FALSE;
+	for (tmp = pastes; tmp != NULL; tmp = next) {
+		Paste *paste = tmp->data;
+
+		next = tmp->next;
+		if (paste->frame == frame && paste->dialog == NULL) {
+			paste_cancel(paste);
+			found = TRUE;
+		}
+	}
+	return found;
+}
+
+int gui_paste_key(Frame *frame, GdkEventKey *event)
+{
+	if (event->keyval != GDK_Escape || pastes == NULL ||
+	    (event->state & (GDK_SHIFT_MASK | GDK_CONTROL_MASK |
+			     GDK_MOD1_MASK)) != 0)
+		return FALSE;
+
+	return gui_paste_cancel(frame);
+}
+
+static void sig_window_destroyed(Window *window)
+{
+	GSList *tmp, *next;
+
+	for (tmp = pastes; tmp != NULL; tmp = next) {
+		Paste *paste = tmp->data;
+
+		next = tmp->next;
+		if (paste->window == window)
+			paste_destroy(paste);
+	}
+}
+
+static void sig_window_item_remove(Window *window, WindowItem *item)
+{
+	GSList *tmp, *next;
+
+	for (tmp = pastes; tmp != NULL; tmp = next) {
+		Paste *paste = tmp->data;
+
+		next = tmp->next;
+		if (paste->item == item)
+			paste_cancel(paste);
+	}
+}
+
+static void sig_server_disconnected(Server *server)
+{
+	GSList *tmp, *next;
+
+	for (tmp = pastes; tmp != NULL; tmp = next) {
+		Paste *paste = tmp->data;
+
+		next = tmp->next;
+		if (paste->server == server)
+			paste_cancel(paste);
+	}
+}
+
+static void sig_frame_destroyed(Frame *frame)
+{
+	GSList *tmp;
+
+	/* keep sending, just without progress */
+	for (tmp = pastes; tmp != NULL; tmp = tmp->next) {
+		Paste *paste = tmp->data;
+
+		if (paste->frame == frame)
+			paste->frame = NULL;
+	}
+}
+
+void gui_pastes_init(void)
+{
+	pastes = NULL;
+
+	settings_add_int("misc", "paste_verify_line_count", 5);
+	settings_add_int("misc", "paste_line_delay", 200);
+
+	signal_add("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_add("window item remove", (SIGNAL_FUNC) sig_window_item_remove);
+	signal_add("server disconnected", (SIGNAL_FUNC) sig_server_disconnected);
+	signal_add("gui frame destroyed", (SIGNAL_FUNC) sig_frame_destroyed);
+}
+
+void gui_pastes_deinit(void)
+{
+	while (pastes != NULL)
+		paste_destroy(pastes->data);
+
+	signal_remove("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_remove("window item remove", (SIGNAL_FUNC) sig_window_item_remove);
+	signal_remove("server disconnected", (SIGNAL_FUNC) sig_server_disconnected);
+	signal_remove("gui frame destroyed", (SIGNAL_FUNC) sig_frame_destroyed);
+}
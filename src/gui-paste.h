@@ -0,0 +1,16 @@
+#ifndef __GUI_PASTE_H
+#define __GUI_PASTE_H
+
+/* Send text which may contain multiple lines. Large pastes are asked
+   to be confirmed first and then sent a line at a time. */
+void gui_paste_send(Frame *frame, Window *window, const char *text);
+/* Cancel pastes started from frame. Returns TRUE if any were found. */
+int gui_paste_cancel(Frame *frame);
+/* Escape cancels pastes started from frame. Returns TRUE if the key
+   was used, otherwise it's left for the key bindings. */
+int gui_paste_key(Frame *frame, GdkEventKey *event);
+
+void gui_pastes_init(void);
+void gui_pastes_deinit(void);
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ gui-prelayout.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+
+#include "gui-frame.h"
+#include "gui-tab.h"
+#include "gui-window.h"
+#include "gui-window-view.h"
+#include "gui-prelayout.h"
+
+/* how long one idle slice may run before yielding */
+#define PRELAYOUT_SLICE_MSECS 5
+
+static GSList *queue; /* Tabs to lay out, most likely to be shown first */
+static int idle_tag;
+
+static int tab_is_queued(Tab *tab)
+{
+	return g_slist_find(queue, tab) != NULL;
+}
+
+static void queue_add(Tab *tab)
+{
+	if (tab == NULL || tab->visible || tab->destroying ||
+	    tab_is_queued(tab))
+		return;
+
+	queue = g_slist_append(queue, tab);
+}
+
+static int tab_data_level_cmp(Tab *tab1, Tab *tab2)
+{
+	return tab2->data_level - tab1->data_level;
+}
+
+/* previously active tab, the tabs next to the active one and then the
+   hidden tabs with most activity */
+static void queue_frame(Frame *frame, int max)
+{
+	GSList *active;
+	Tab *tab;
+	int page, i;
+
+	queue_add(frame->prev_tab);
+
+	page = gtk_notebook_get_current_page(frame->notebook);
+	queue_add(gui_tab_get_page(frame, page+1));
+	if (page > 0)
+		queue_add(gui_tab_get_page(frame, page-1));
+
+	active = NULL;
+	for (i = 0; (tab = gui_tab_get_page(frame, i)) != NULL; i++) {
+		if (tab->data_level > 0 && !tab->visible)
+			active = g_slist_prepend(active, tab);
+	}
+	active = g_slist_sort(active, (GCompareFunc) tab_data_level_cmp);
+
+	while (active != NULL) {
+		if ((int)g_slist_length(queue) >= max)
+			break;
+		queue_add(active->data);
+		active = g_slist_remove(active, active->data);
+	}
+	g_slist_free(active);
+}
+
+static void view_prelayout(WindowView *view)
+{
+	GtkTextIter iter;
+
+	/* the text view gets its layout when realized, scrolling to the
+	   end validates the bottom screenful of it */
+	gtk_widget_realize(GTK_WIDGET(view->view));
+	gtk_text_buffer_get_end_iter(view->window->buffer, &iter);
+	gtk_text_view_scroll_to_iter(view->view, &iter, 0, TRUE, 0, 1);
+	view->prelaid = TRUE;
+}
+
+/* Do one step of work for the first tab in queue. Returns FALSE if
+   the tab was finished. */
+static int tab_prelayout_step(Tab *tab)
+{
+	GList *tmp;
+
+	if (tab->visible || tab->destroying)
+		return FALSE;
+
+	if (!tab->realized) {
+		gui_tab_realize(tab);
+		return TRUE;
+	}
+
+	for (tmp = tab->panes; tmp != NULL; tmp = tmp->next) {
+		TabPane *pane = tmp->data;
+		WindowView *view = pane->view;
+
+		if (view != NULL && view->realized && !view->prelaid) {
+			view_prelayout(view);
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static gboolean sig_idle(void)
+{
+	GTimer *timer;
+
+	timer = g_timer_new();
+	while (queue != NULL) {
+		if (!tab_prelayout_step(queue->data))
+			queue = g_slist_remove(queue, queue->data);
+
+		/* let the key presses through */
+		if (g_timer_elapsed(timer, NULL)*1000 >= PRELAYOUT_SLICE_MSECS ||
+		    gtk_events_pending())
+			break;
+	}
+	g_timer_destroy(timer);
+
+	if (queue != NULL)
+		return TRUE;
+
+	idle_tag = -1;
+	return FALSE;
+}
+
+static void prelayout_reschedule(void)
+{
+	GSList *tmp;
+	int max;
+
+	g_slist_free(queue);
+	queue = NULL;
+
+	max = settings_get_int("gui_prelayout_tabs");
+	if (max > 0) {
+		for (tmp = frames; tmp != NULL; tmp = tmp->next) {
+			Frame *frame = tmp->data;
+
+			if (!frame->destroying)
+				queue_frame(frame, max);
+		}
+	}
+
+	if (queue != NULL && idle_tag == -1) {
+		idle_tag = g_idle_add_full(G_PRIORITY_LOW,
+					   (GSourceFunc) sig_idle, NULL, NULL);
+	} else if (queue == NULL && idle_tag != -1) {
+		g_source_remove(idle_tag);
+		idle_tag = -1;
+	}
+}
+
+static void sig_tab_destroyed(Tab *tab)
+{
+	queue = g_slist_remove(queue, tab);
+}
+
+void gui_prelayout_init(void)
+{
+	queue = NULL;
+	idle_tag = -1;
+
+	settings_add_int("lookandfeel", "gui_prelayout_tabs", 4);
+
+	signal_add_last("window changed", (SIGNAL_FUNC) prelayout_reschedule);
+	signal_add_last("window activity", (SIGNAL_FUNC) prelayout_reschedule);
+	signal_add_last("window hilight", (SIGNAL_FUNC) prelayout_reschedule);
+	signal_add("gui tab destroyed", (SIGNAL_FUNC) sig_tab_destroyed);
+}
+
+void gui_prelayout_deinit(void)
+{
+	if (idle_tag != -1)
+		g_source_remove(idle_tag);
+	g_slist_free(queue);
+
+	signal_remove("window changed", (SIGNAL_FUNC) prelayout_reschedule);
+	signal_remove("window activity", (SIGNAL_FUNC) prelayout_reschedule);
+	signal_remove("window hilight", (SIGNAL_FUNC) prelayout_reschedule);
+	signal_remove("gui tab destroyed", (SIGNAL_FUNC) sig_tab_destroyed);
+}
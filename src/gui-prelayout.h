@@ -0,0 +1,10 @@
+#ifndef __GUI_PRELAYOUT_H
+#define __GUI_PRELAYOUT_H
+
+/* Hidden tabs that are likely to be shown next are realized and their
+   text views laid out in small idle slices, so switching to them
+   doesn't need to do it all at once. */
+void gui_prelayout_init(void);
+void gui_prelayout_deinit(void);
+
+#endif
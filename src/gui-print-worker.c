@@ -0,0 +1,177 @@
+/*
+ gui-print-worker.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+
+#include "gui-charset.h"
+#include "gui-scan.h"
+#include "gui-window.h"
+#include "gui-print-worker.h"
+
+void gui_window_print_job(PrintJob *job);
+
+static GThreadPool *pool;
+static GQueue *jobs; /* PrintJob, in the order they were printed */
+static volatile gint wakeup_pending;
+
+GArray *gui_text_split_words(const char *text)
+{
+	GArray *words;
+	TextWord word;
+	int pos, len;
+
+	words = g_array_new(FALSE, FALSE, sizeof(TextWord));
+	len = strlen(text);
+	for (pos = 0; pos < len; pos += word.len+1) {
+		word.start = pos;
+		word.len = gui_scan_space(text+pos, len-pos);
+		if (word.len > 0)
+			g_array_append_val(words, word);
+	}
+	return words;
+}
+
+/* only touches the job, so this can be run in any thread */
+static void print_job_prepare(PrintJob *job)
+{
+	if (job->raw == NULL)
+		return;
+
+	job->text = gui_charset_to_utf8(job->charset, job->raw);
+	job->words = gui_text_split_words(job->text);
+}
+
+void gui_print_job_free(PrintJob *job)
+{
+	if (job->words != NULL)
+		g_array_free(job->words, TRUE);
+	g_free(job->raw);
+	g_free(job->text);
+	g_free(job->server_tag);
+	g_free(job->target);
+	g_free(job->repeat_key);
+	g_free(job->charset);
+	g_free(job->nick);
+	g_free(job);
+}
+
+/* apply the finished jobs from the head of the queue, stop at the first
+   one that's still being worked on to keep the order */
+static void jobs_apply_ready(void)
+{
+	PrintJob *job;
+
+	while ((job = g_queue_peek_head(jobs)) != NULL &&
+	       g_atomic_int_get(&job->ready)) {
+		g_queue_pop_head(jobs);
+		if (job->window != NULL)
+			gui_window_print_job(job);
+		gui_print_job_free(job);
+	}
+}
+
+static gboolean jobs_drain(void)
+{
+	/* the workers may have queued us while being deinitialized */
+	if (jobs == NULL)
+		return FALSE;
+
+	/* reset first, jobs finishing after this will wake us again */
+	g_atomic_int_set(&wakeup_pending, 0);
+	jobs_apply_ready();
+	return FALSE;
+}
+
+static void worker_func(PrintJob *job, void *user_data)
+{
+	print_job_prepare(job);
+	g_atomic_int_set(&job->ready, 1);
+
+	if (g_atomic_int_compare_and_exchange(&wakeup_pending, 0, 1)) {
+		/* before GTK redraws, so the text gets drawn at once */
+		g_idle_add_full(G_PRIORITY_HIGH_IDLE,
+				(GSourceFunc) jobs_drain, NULL, NULL);
+	}
+}
+
+void gui_print_worker_add(PrintJob *job)
+{
+	if (pool == NULL || (job->raw == NULL && g_queue_is_empty(jobs))) {
+		/* nothing to do in a thread */
+		print_job_prepare(job);
+		job->ready = 1;
+		g_queue_push_tail(jobs, job);
+		jobs_apply_ready();
+		return;
+	}
+
+	g_queue_push_tail(jobs, job);
+	if (job->raw == NULL)
+		g_atomic_int_set(&job->ready, 1);
+	else
+		g_thread_pool_push(pool, job, NULL);
+}
+
+static void sig_gui_window_destroyed(WindowGui *window)
+{
+	GList *tmp;
+
+	/* still being prepared, just don't print them anywhere */
+	for (tmp = jobs->head; tmp != NULL; tmp = tmp->next) {
+		PrintJob *job = tmp->data;
+
+		if (job->window == window)
+			job->window = NULL;
+	}
+}
+
+void gui_print_workers_init(void)
+{
+	int threads;
+
+	settings_add_int("misc", "gui_print_threads", 2);
+
+	jobs = g_queue_new();
+	wakeup_pending = 0;
+
+	threads = settings_get_int("gui_print_threads");
+	pool = threads <= 0 || !g_thread_supported() ? NULL :
+		g_thread_pool_new((GFunc) worker_func, NULL,
+				  threads, FALSE, NULL);
+
+	signal_add("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+}
+
+void gui_print_workers_deinit(void)
+{
+	if (pool != NULL) {
+		/* wait for the running jobs and print what's left */
+		g_thread_pool_free(pool, FALSE, TRUE);
+		pool = NULL;
+	}
+	jobs_apply_ready();
+	g_queue_free(jobs);
+	jobs = NULL;
+
+	signal_remove("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+}
@@ -0,0 +1,42 @@
+#ifndef __GUI_PRINT_WORKER_H
+#define __GUI_PRINT_WORKER_H
+
+typedef struct {
+	int start, len; /* in bytes */
+} TextWord;
+
+/* Printed text goes through worker threads, which convert it to UTF-8
+   and split it to words. The main loop then adds it to the window in
+   the order it was printed. */
+typedef struct {
+	WindowGui *window; /* NULL if the window was destroyed */
+
+	char *raw; /* as printed, NULL for the end of line */
+	int fg, bg, flags;
+	char *server_tag, *target;
+	char *repeat_key;
+	char *charset; /* NULL = default */
+
+	/* for the line information */
+	time_t time;
+	int level;
+	char *nick;
+	unsigned int hilight:1;
+
+	/* set by the worker */
+	char *text; /* UTF-8 */
+	GArray *words; /* TextWord in text */
+	volatile gint ready;
+} PrintJob;
+
+/* Words as used for context tags, separated by whitespace. */
+GArray *gui_text_split_words(const char *text);
+
+/* The job is freed after it's been printed. */
+void gui_print_worker_add(PrintJob *job);
+void gui_print_job_free(PrintJob *job);
+
+void gui_print_workers_init(void);
+void gui_print_workers_deinit(void);
+
+#endif
@@ -0,0 +1,412 @@
+/*
+ gui-scan.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "commands.h"
+#include "levels.h"
+
+#include "printtext.h"
+
+#include "gui-scan.h"
+
+/* the vector versions are picked at runtime, so they're built with
+   target attributes instead of requiring -msse2/-mavx2 for everything */
+#if defined (__GNUC__) && __GNUC__ >= 5 && \
+	(defined (__x86_64__) || defined (__i386__))
+#  define SCAN_X86
+#  include <immintrin.h>
+#endif
+
+typedef struct {
+	const char *name;
+	int (*ascii)(const char *text, int len);
+	int (*space)(const char *text, int len);
+	int (*eol)(const char *text, int len);
+} ScanImpl;
+
+#define IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+#define IS_EOL(c) ((c) == '\r' || (c) == '\n')
+
+static int scalar_ascii(const char *text, int len)
+{
+	int i;
+
+	for (i = 0; i < len && (text[i] & 0x80) == 0; i++) ;
+	return i;
+}
+
+static int scalar_space(const char *text, int len)
+{
+	int i;
+
+	for (i = 0; i < len && !IS_SPACE(text[i]); i++) ;
+	return i;
+}
+
+static int scalar_eol(const char *text, int len)
+{
+	int i;
+
+	for (i = 0; i < len && !IS_EOL(text[i]); i++) ;
+	return i;
+}
+
+#ifdef SCAN_X86
+__attribute__((target("sse2")))
+static int sse2_ascii(const char *text, int len)
+{
+	__m128i v;
+	int i, mask;
+
+	for (i = 0; i+16 <= len; i += 16) {
+		v = _mm_loadu_si128((const __m128i *) (text+i));
+		mask = _mm_movemask_epi8(v);
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+	return i + scalar_ascii(text+i, len-i);
+}
+
+__attribute__((target("sse2")))
+static int sse2_space(const char *text, int len)
+{
+	__m128i v, m;
+	int i, mask;
+
+	for (i = 0; i+16 <= len; i += 16) {
+		v = _mm_loadu_si128((const __m128i *) (text+i));
+		m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+					      _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+				 _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+					      _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+		mask = _mm_movemask_epi8(m);
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+	return i + scalar_space(text+i, len-i);
+}
+
+__attribute__((target("sse2")))
+static int sse2_eol(const char *text, int len)
+{
+	__m128i v, m;
+	int i, mask;
+
+	for (i = 0; i+16 <= len; i += 16) {
+		v = _mm_loadu_si128((const __m128i *) (text+i));
+		m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+				 _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+		mask = _mm_movemask_epi8(m);
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+	return i + scalar_eol(text+i, len-i);
+}
+
+__attribute__((target("avx2")))
+static int avx2_ascii(const char *text, int len)
+{
+	__m256i v;
+	int i;
+	unsigned int mask;
+
+	for (i = 0; i+32 <= len; i += 32) {
+		v = _mm256_loadu_si256((const __m256i *) (text+i));
+		mask = _mm256_movemask_epi8(v);
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+	return i + scalar_ascii(text+i, len-i);
+}
+
+__attribute__((target("avx2")))
+static int avx2_space(const char *text, int len)
+{
+	__m256i v, m;
+	int i;
+	unsigned int mask;
+
+	for (i = 0; i+32 <= len; i += 32) {
+		v = _mm256_loadu_si256((const __m256i *) (text+i));
+		m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+						    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+				    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+						    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+		mask = _mm256_movemask_epi8(m);
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+	return i + scalar_space(text+i, len-i);
+}
+
+__attribute__((target("avx2")))
+static int avx2_eol(const char *text, int len)
+{
+	__m256i v, m;
+	int i;
+	unsigned int mask;
+
+	for (i = 0; i+32 <= len; i += 32) {
+		v = _mm256_loadu_si256((const __m256i *) (text+i));
+		m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+				    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+		mask = _mm256_movemask_epi8(m);
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+	return i + scalar_eol(text+i, len-i);
+}
+#endif
+
+static ScanImpl impls[] = {
+	{ "scalar", scalar_ascii, scalar_space, scalar_eol },
+#ifdef SCAN_X86
+	{ "sse2", sse2_ascii, sse2_space, sse2_eol },
+	{ "avx2", avx2_ascii, avx2_space, avx2_eol },
+#endif
+	{ NULL, NULL, NULL, NULL }
+};
+
+/* set once at startup, before the print workers are started */
+static const ScanImpl *scan;
+
+static int impl_supported(const ScanImpl *impl)
+{
+#ifdef SCAN_X86
+	if (strcmp(impl->name, "sse2") == 0)
+		return __builtin_cpu_supports("sse2");
+	if (strcmp(impl->name, "avx2") == 0)
+		return __builtin_cpu_supports("avx2");
+#endif
+	return TRUE;
+}
+
+int gui_scan_ascii(const char *text, int len)
+{
+	return scan->ascii(text, len);
+}
+
+int gui_scan_space(const char *text, int len)
+{
+	return scan->space(text, len);
+}
+
+int gui_scan_eol(const char *text, int len)
+{
+	return scan->eol(text, len);
+}
+
+int gui_scan_utf8_validate(const char *text, int len)
+{
+	int pos;
+
+	pos = scan->ascii(text, len);
+	return pos == len || g_utf8_validate(text+pos, len-pos, NULL);
+}
+
+static double bench_kernel(int (*func)(const char *, int),
+			   const char *text, int len, int rounds)
+{
+	GTimer *timer;
+	double secs;
+	int i, pos;
+
+	timer = g_timer_new();
+	for (i = 0; i < rounds; i++) {
+		/* scan the whole buffer in line sized pieces */
+		for (pos = 0; pos < len; pos++)
+			pos += func(text+pos, len-pos);
+	}
+	secs = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	return secs <= 0 ? 0 : (double) len * rounds / secs / (1024*1024);
+}
+
+/* SYNTAX: GUI BENCH SCAN [<kbytes>] */
+static void cmd_gui_bench_scan(const char *data)
+{
+	const ScanImpl *impl;
+	char *text;
+	int i, len, rounds;
+
+	len = (*data == '\0' ? 1024 : atoi(data)) * 1024;
+	if (len <= 0)
+		return;
+
+	/* ASCII words with a line break every 400 bytes */
+	text = g_malloc(len);
+	for (i = 0; i < len; i++) {
+		text[i] = i % 400 == 399 ? '\n' :
+			i % 7 == 6 ? ' ' : 'a' + i % 26;
+	}
+	rounds = 64*1024*1024 / len + 1;
+
+	for (impl = impls; impl->name != NULL; impl++) {
+		if (!impl_supported(impl))
+			continue;
+
+		/* ascii scans until the end, the others until the next
+		   separator */
+		printtext_window(active_win, MSGLEVEL_CLIENTNOTICE,
+				 "%s%s: ascii %.0f MB/s, space %.0f MB/s, "
+				 "eol %.0f MB/s", impl->name,
+				 impl == scan ? " (used)" : "",
+				 bench_kernel(impl->ascii, text, len, rounds),
+				 bench_kernel(impl->space, text, len, rounds),
+				 bench_kernel(impl->eol, text, len, rounds));
+	}
+	g_free(text);
+}
+
+#define SELFTEST_LEN 160 /* a few AVX2 blocks and a tail */
+#define SELFTEST_ALIGN 32
+#define SELFTEST_RANDOM 10000
+
+/* Returns the first difference from the scalar kernel, NULL if none.
+   Bytes after len match every kernel, so reading past it shows up. */
+static char *selftest_kernel(int (*func)(const char *, int),
+			     int (*scalar)(const char *, int))
+{
+	static const char random_bytes[] = "ab \t\r\n\x80\xff";
+	char buf[SELFTEST_ALIGN + SELFTEST_LEN + 2];
+	unsigned char c;
+	GRand *rand;
+	char *text;
+	int offset, len, pos, i, got, expected;
+
+	for (offset = 0; offset < SELFTEST_ALIGN; offset++) {
+		text = buf + offset;
+		for (len = 0; len <= SELFTEST_LEN; len++) {
+			memset(text, 'a', len);
+			text[len] = '\n';
+			text[len+1] = '\x80';
+			if ((got = func(text, len)) != len) {
+				return g_strdup_printf("len %d offset %d: got %d",
+						       len, offset, got);
+			}
+
+			/* a single byte of every value at the end, and at
+			   every position of the longest text */
+			for (pos = len == SELFTEST_LEN ? 0 : MAX(len-1, 0);
+			     pos < len; pos++) {
+				for (i = 0; i < 256; i++) {
+					c = i;
+					text[pos] = c;
+					expected = scalar((char *) &c, 1) == 0 ?
+						pos : len;
+					got = func(text, len);
+					text[pos] = 'a';
+
+					if (got != expected) {
+						return g_strdup_printf("len %d offset %d byte 0x%02x at %d: got %d, expected %d",
+								       len, offset, c, pos, got, expected);
+					}
+				}
+			}
+		}
+	}
+
+	/* mixed text, compared against the scalar kernel as a whole */
+	rand = g_rand_new_with_seed(1);
+	for (i = 0; i < SELFTEST_RANDOM; i++) {
+		offset = g_rand_int_range(rand, 0, SELFTEST_ALIGN);
+		len = g_rand_int_range(rand, 0, SELFTEST_LEN+1);
+		text = buf + offset;
+		for (pos = 0; pos < len; pos++) {
+			text[pos] = g_rand_int_range(rand, 0, 8) != 0 ? 'a' :
+				random_bytes[g_rand_int_range(rand, 0, sizeof(random_bytes)-1)];
+		}
+		text[len] = '\n';
+		text[len+1] = '\x80';
+
+		got = func(text, len);
+		expected = scalar(text, len);
+		if (got != expected) {
+			g_rand_free(rand);
+			return g_strdup_printf("random text len %d offset %d: got %d, expected %d",
+					       len, offset, got, expected);
+		}
+	}
+	g_rand_free(rand);
+	return NULL;
+}
+
+/* SYNTAX: GUI SELFTEST SCAN */
+static void cmd_gui_selftest_scan(void)
+{
+	const ScanImpl *impl;
+	char *ascii, *space, *eol;
+
+	for (impl = impls+1; impl->name != NULL; impl++) {
+		if (!impl_supported(impl)) {
+			printtext_window(active_win, MSGLEVEL_CLIENTNOTICE,
+					 "%s: not supported by this CPU",
+					 impl->name);
+			continue;
+		}
+
+		ascii = selftest_kernel(impl->ascii, impls[0].ascii);
+		space = selftest_kernel(impl->space, impls[0].space);
+		eol = selftest_kernel(impl->eol, impls[0].eol);
+
+		if (ascii == NULL && space == NULL && eol == NULL) {
+			printtext_window(active_win, MSGLEVEL_CLIENTNOTICE,
+					 "%s: ok", impl->name);
+		}
+		if (ascii != NULL) {
+			printtext_window(active_win, MSGLEVEL_CLIENTERROR,
+					 "%s ascii: %s", impl->name, ascii);
+		}
+		if (space != NULL) {
+			printtext_window(active_win, MSGLEVEL_CLIENTERROR,
+					 "%s space: %s", impl->name, space);
+		}
+		if (eol != NULL) {
+			printtext_window(active_win, MSGLEVEL_CLIENTERROR,
+					 "%s eol: %s", impl->name, eol);
+		}
+		g_free(ascii);
+		g_free(space);
+		g_free(eol);
+	}
+}
+
+void gui_scan_init(void)
+{
+	const ScanImpl *impl;
+
+	/* the last supported one is the fastest */
+	for (impl = impls; impl->name != NULL; impl++) {
+		if (impl_supported(impl))
+			scan = impl;
+	}
+
+	command_bind("gui bench scan", NULL, (SIGNAL_FUNC) cmd_gui_bench_scan);
+	command_bind("gui selftest scan", NULL, (SIGNAL_FUNC) cmd_gui_selftest_scan);
+}
+
+void gui_scan_deinit(void)
+{
+	command_unbind("gui bench scan", (SIGNAL_FUNC) cmd_gui_bench_scan);
+	command_unbind("gui selftest scan", (SIGNAL_FUNC) cmd_gui_selftest_scan);
+}
@@ -0,0 +1,21 @@
+#ifndef __GUI_SCAN_H
+#define __GUI_SCAN_H
+
+/* Byte scanning used by the print and input paths. SSE2 or AVX2
+   versions are used if the CPU supports them. These can be called from
+   any thread. All of them return len if nothing was found. */
+
+/* Returns the length of the 7bit ASCII prefix of text. */
+int gui_scan_ascii(const char *text, int len);
+/* Returns the position of the first space, tab, \r or \n. */
+int gui_scan_space(const char *text, int len);
+/* Returns the position of the first \r or \n. */
+int gui_scan_eol(const char *text, int len);
+
+/* Like g_utf8_validate(), but skips ASCII quickly. */
+int gui_scan_utf8_validate(const char *text, int len);
+
+void gui_scan_init(void);
+void gui_scan_deinit(void);
+
+#endif
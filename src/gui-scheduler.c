@@ -0,0 +1,208 @@
+/*
+ gui-scheduler.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+#include "levels.h"
+
+#include "printtext.h"
+
+#include "gui-scheduler.h"
+
+typedef struct {
+	GuiJobFunc func;
+	void *data;
+	GuiJobPriority priority;
+} GuiJob;
+
+static GQueue *queues[GUI_JOB_PRIORITIES]; /* GuiJob, oldest first */
+static GHashTable *job_set; /* GuiJob => GuiJob */
+static int idle_tag;
+
+static struct {
+	unsigned long jobs[GUI_JOB_PRIORITIES], merged;
+	unsigned long slices, over_budget;
+} sched_stats;
+
+static guint job_hash(const GuiJob *job)
+{
+	return GPOINTER_TO_UINT(job->func) ^ GPOINTER_TO_UINT(job->data);
+}
+
+static gint job_equal(const GuiJob *job1, const GuiJob *job2)
+{
+	return job1->func == job2->func && job1->data == job2->data;
+}
+
+static GuiJob *job_next(int max_priority)
+{
+	GuiJob *job;
+	int i;
+
+	for (i = 0; i <= max_priority; i++) {
+		job = g_queue_pop_head(queues[i]);
+		if (job != NULL) {
+			g_hash_table_remove(job_set, job);
+			return job;
+		}
+	}
+	return NULL;
+}
+
+static void job_run(GuiJob *job)
+{
+	sched_stats.jobs[job->priority]++;
+	job->func(job->data);
+	g_free(job);
+}
+
+static gboolean sig_idle(void)
+{
+	GTimer *timer;
+	GuiJob *job;
+	double budget;
+
+	sched_stats.slices++;
+	budget = settings_get_int("gui_scheduler_budget") / 1000.0;
+
+	/* input jobs always run, the rest only while there's time */
+	while ((job = job_next(GUI_JOB_INPUT)) != NULL)
+		job_run(job);
+
+	timer = g_timer_new();
+	while ((job = job_next(GUI_JOB_PRIORITIES-1)) != NULL) {
+		job_run(job);
+
+		if (g_timer_elapsed(timer, NULL) >= budget) {
+			sched_stats.over_budget++;
+			break;
+		}
+	}
+	g_timer_destroy(timer);
+
+	if (g_hash_table_size(job_set) > 0)
+		return TRUE;
+
+	idle_tag = -1;
+	return FALSE;
+}
+
+void gui_scheduler_add(GuiJobPriority priority, GuiJobFunc func, void *data)
+{
+	GuiJob *job, lookup;
+
+	g_return_if_fail(priority >= 0 && priority < GUI_JOB_PRIORITIES);
+
+	lookup.func = func;
+	lookup.data = data;
+	job = g_hash_table_lookup(job_set, &lookup);
+	if (job != NULL) {
+		sched_stats.merged++;
+		if (job->priority <= priority)
+			return;
+
+		/* more urgent now */
+		g_queue_remove(queues[job->priority], job);
+		job->priority = priority;
+		g_queue_push_tail(queues[priority], job);
+		return;
+	}
+
+	job = g_new(GuiJob, 1);
+	job->func = func;
+	job->data = data;
+	job->priority = priority;
+	g_hash_table_insert(job_set, job, job);
+	g_queue_push_tail(queues[priority], job);
+
+	/* below GDK's event and redraw priorities, so input is always
+	   handled first */
+	if (idle_tag == -1) {
+		idle_tag = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+					   (GSourceFunc) sig_idle, NULL, NULL);
+	}
+}
+
+void gui_scheduler_cancel(void *data)
+{
+	GList *tmp, *next;
+	int i;
+
+	for (i = 0; i < GUI_JOB_PRIORITIES; i++) {
+		for (tmp = queues[i]->head; tmp != NULL; tmp = next) {
+			GuiJob *job = tmp->data;
+
+			next = tmp->next;
+			if (job->data == data) {
+				g_hash_table_remove(job_set, job);
+				g_queue_delete_link(queues[i], tmp);
+				g_free(job);
+			}
+		}
+	}
+}
+
+static void sig_gui_stats(Window *window)
+{
+	printtext_window(window, MSGLEVEL_CLIENTNOTICE,
+			 "Scheduler: %lu input, %lu visible, %lu hidden, "
+			 "%lu background jobs, %lu merged, %lu of %lu slices "
+			 "over budget", sched_stats.jobs[GUI_JOB_INPUT],
+			 sched_stats.jobs[GUI_JOB_VISIBLE],
+			 sched_stats.jobs[GUI_JOB_HIDDEN],
+			 sched_stats.jobs[GUI_JOB_BACKGROUND],
+			 sched_stats.merged, sched_stats.over_budget,
+			 sched_stats.slices);
+}
+
+void gui_scheduler_init(void)
+{
+	int i;
+
+	for (i = 0; i < GUI_JOB_PRIORITIES; i++)
+		queues[i] = g_queue_new();
+	job_set = g_hash_table_new((GHashFunc) job_hash,
+				   (GCompareFunc) job_equal);
+	idle_tag = -1;
+
+	settings_add_int("lookandfeel", "gui_scheduler_budget", 8);
+
+	signal_add("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
+
+void gui_scheduler_deinit(void)
+{
+	GuiJob *job;
+	int i;
+
+	if (idle_tag != -1)
+		g_source_remove(idle_tag);
+
+	for (i = 0; i < GUI_JOB_PRIORITIES; i++) {
+		while ((job = g_queue_pop_head(queues[i])) != NULL)
+			g_free(job);
+		g_queue_free(queues[i]);
+	}
+	g_hash_table_destroy(job_set);
+
+	signal_remove("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
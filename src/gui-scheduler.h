@@ -0,0 +1,26 @@
+#ifndef __GUI_SCHEDULER_H
+#define __GUI_SCHEDULER_H
+
+typedef enum {
+	GUI_JOB_INPUT, /* run as soon as possible */
+	GUI_JOB_VISIBLE, /* updates something that's shown */
+	GUI_JOB_HIDDEN, /* updates a hidden window */
+	GUI_JOB_BACKGROUND, /* maintenance */
+
+	GUI_JOB_PRIORITIES
+} GuiJobPriority;
+
+typedef void (*GuiJobFunc) (void *data);
+
+/* Run func(data) later from idle, after GDK has handled its events.
+   Jobs are run in priority order, but only for gui_scheduler_budget
+   msecs at a time (input jobs always run). The same func and data is
+   queued only once, with the most urgent priority it was given. */
+void gui_scheduler_add(GuiJobPriority priority, GuiJobFunc func, void *data);
+/* Forget the queued jobs of data, it's being destroyed. */
+void gui_scheduler_cancel(void *data);
+
+void gui_scheduler_init(void);
+void gui_scheduler_deinit(void);
+
+#endif
@@ -0,0 +1,336 @@
+/*
+ gui-style.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+#include "levels.h"
+
+#include "printtext.h"
+
+#include "gui-colors.h"
+#include "gui-style.h"
+#include "gui-window.h"
+
+#define STYLE_COLOR_SET 0x1000000
+
+/* foreground, background and boldness of text. All the windows share
+   the same tags, and they're reused when no window shows them anymore
+   so the tag table doesn't grow with every color combination seen. */
+typedef struct {
+	guint32 fg, bg; /* 0xRRGGBB | STYLE_COLOR_SET, or 0 = default */
+	unsigned int bold:1;
+
+	GtkTextTag *tag;
+	int refcount; /* windows that have text with this style */
+	GList *idle_link; /* in idle_styles when refcount is 0 */
+} Style;
+
+typedef struct {
+	GHashTable *used; /* Style => last line it was used in */
+	int lines_removed; /* to get absolute line numbers */
+} StyleWindow;
+
+static GtkTextTagTable *tag_table;
+static GHashTable *styles; /* Style => Style */
+static GQueue *idle_styles; /* Style, least recently used first */
+static GHashTable *style_windows; /* WindowGui => StyleWindow */
+
+static struct {
+	unsigned long created, reused, destroyed;
+} style_stats;
+
+static guint style_hash(const Style *style)
+{
+	return style->fg * 31 + style->bg * 7 + style->bold;
+}
+
+static gint style_equal(const Style *style1, const Style *style2)
+{
+	return style1->fg == style2->fg && style1->bg == style2->bg &&
+		style1->bold == style2->bold;
+}
+
+GtkTextTagTable *gui_style_tag_table(void)
+{
+	return tag_table;
+}
+
+static guint32 color_rgb(const GdkColor *color)
+{
+	return STYLE_COLOR_SET | ((color->red >> 8) << 16) |
+		((color->green >> 8) << 8) | (color->blue >> 8);
+}
+
+static void color_to_gdk(guint32 rgb, GdkColor *color)
+{
+	color->pixel = 0;
+	color->red = ((rgb >> 16) & 0xff) * 0x101;
+	color->green = ((rgb >> 8) & 0xff) * 0x101;
+	color->blue = (rgb & 0xff) * 0x101;
+}
+
+/* fill style's colors from what was printed */
+static void style_resolve(Style *style, int fg, int bg, int flags)
+{
+	style->fg = style->bg = 0;
+	style->bold = FALSE;
+
+	if (flags & GUI_PRINT_FLAG_COLOR_24_FG)
+		style->fg = STYLE_COLOR_SET | (fg & 0xffffff);
+	if (flags & GUI_PRINT_FLAG_COLOR_24_BG)
+		style->bg = STYLE_COLOR_SET | (bg & 0xffffff);
+
+	if (flags & GUI_PRINT_FLAG_MIRC_COLOR) {
+		if ((flags & GUI_PRINT_FLAG_COLOR_24_FG) == 0 &&
+		    fg >= 0 && fg < MIRC_COLORS)
+			style->fg = color_rgb(&mirc_colors[fg]);
+		if ((flags & GUI_PRINT_FLAG_COLOR_24_BG) == 0 &&
+		    bg >= 0 && bg < MIRC_COLORS)
+			style->bg = color_rgb(&mirc_colors[bg]);
+		style->bold = (flags & GUI_PRINT_FLAG_BOLD) != 0;
+		return;
+	}
+
+	/* normal color, bold and blink make the base colors brighter */
+	if ((flags & GUI_PRINT_FLAG_COLOR_24_FG) == 0) {
+		if (fg >= 0 && fg < 8 && (flags & GUI_PRINT_FLAG_BOLD))
+			fg |= 8;
+		if (fg >= 0 && fg < EXTENDED_COLORS)
+			style->fg = color_rgb(&extended_colors[fg]);
+		else if (flags & GUI_PRINT_FLAG_BOLD)
+			style->fg = color_rgb(&colors[COLOR_BOLD]);
+	}
+	if ((flags & GUI_PRINT_FLAG_COLOR_24_BG) == 0) {
+		if (bg >= 0 && bg < 8 && (flags & GUI_PRINT_FLAG_BLINK))
+			bg |= 8;
+		if (bg >= 0 && bg < EXTENDED_COLORS)
+			style->bg = color_rgb(&extended_colors[bg]);
+	}
+
+	/* the extended colors can't be made brighter */
+	style->bold = (flags & GUI_PRINT_FLAG_BOLD) &&
+		((flags & GUI_PRINT_FLAG_COLOR_24_FG) || fg >= DEFAULT_COLORS);
+}
+
+static void style_set_tag(Style *style)
+{
+	GdkColor color;
+
+	g_object_set(G_OBJECT(style->tag), "foreground-set", FALSE,
+		     "background-set", FALSE, "weight-set", FALSE, NULL);
+
+	if (style->fg != 0) {
+		color_to_gdk(style->fg, &color);
+		g_object_set(G_OBJECT(style->tag), "foreground-gdk",
+			     &color, NULL);
+	}
+	if (style->bg != 0) {
+		color_to_gdk(style->bg, &color);
+		g_object_set(G_OBJECT(style->tag), "background-gdk",
+			     &color, NULL);
+	}
+	if (style->bold) {
+		g_object_set(G_OBJECT(style->tag), "weight",
+			     PANGO_WEIGHT_BOLD, NULL);
+	}
+}
+
+static Style *style_create(const Style *lookup)
+{
+	Style *style;
+
+	if ((int)g_hash_table_size(styles) >=
+	    settings_get_int("gui_style_tags_max") &&
+	    !g_queue_is_empty(idle_styles)) {
+		/* reuse the tag of the least recently used style */
+		style = g_queue_pop_head(idle_styles);
+		style->idle_link = NULL;
+		g_hash_table_remove(styles, style);
+		style_stats.reused++;
+	} else {
+		style = g_new0(Style, 1);
+		style->tag = gtk_text_tag_new(NULL);
+		gtk_text_tag_table_add(tag_table, style->tag);
+		g_object_unref(G_OBJECT(style->tag));
+
+		/* below everything else, so nick colors and context
+		   tags win over the colors printed with the text */
+		gtk_text_tag_set_priority(style->tag, 0);
+		style_stats.created++;
+	}
+
+	style->fg = lookup->fg;
+	style->bg = lookup->bg;
+	style->bold = lookup->bold;
+	style_set_tag(style);
+
+	g_hash_table_insert(styles, style, style);
+	return style;
+}
+
+static void style_ref(Style *style)
+{
+	if (style->refcount++ == 0 && style->idle_link != NULL) {
+		g_queue_delete_link(idle_styles, style->idle_link);
+		style->idle_link = NULL;
+	}
+}
+
+static void style_unref(Style *style)
+{
+	if (--style->refcount > 0)
+		return;
+
+	if ((int)g_hash_table_size(styles) >
+	    settings_get_int("gui_style_tags_max")) {
+		/* we had to go over the limit, shrink back */
+		g_hash_table_remove(styles, style);
+		gtk_text_tag_table_remove(tag_table, style->tag);
+		g_free(style);
+		style_stats.destroyed++;
+		return;
+	}
+
+	g_queue_push_tail(idle_styles, style);
+	style->idle_link = idle_styles->tail;
+}
+
+GtkTextTag *gui_style_get(WindowGui *window, int line,
+			  int fg, int bg, int flags)
+{
+	StyleWindow *rec;
+	Style lookup, *style;
+	void *value;
+
+	style_resolve(&lookup, fg, bg, flags);
+	if (lookup.fg == 0 && lookup.bg == 0 && !lookup.bold)
+		return NULL;
+
+	style = g_hash_table_lookup(styles, &lookup);
+	if (style == NULL)
+		style = style_create(&lookup);
+
+	rec = g_hash_table_lookup(style_windows, window);
+	if (rec == NULL) {
+		rec = g_new0(StyleWindow, 1);
+		rec->used = g_hash_table_new((GHashFunc) g_direct_hash,
+					     (GCompareFunc) g_direct_equal);
+		g_hash_table_insert(style_windows, window, rec);
+	}
+
+	line += rec->lines_removed;
+	if (!g_hash_table_lookup_extended(rec->used, style, NULL, &value))
+		style_ref(style);
+	g_hash_table_insert(rec->used, style, GINT_TO_POINTER(line));
+	return style->tag;
+}
+
+static int style_window_release(Style *style, void *value, int *line)
+{
+	if (line != NULL && GPOINTER_TO_INT(value) >= *line)
+		return FALSE;
+
+	style_unref(style);
+	return TRUE;
+}
+
+void gui_style_window_trim(WindowGui *window, int lines)
+{
+	StyleWindow *rec;
+
+	rec = g_hash_table_lookup(style_windows, window);
+	if (rec == NULL)
+		return;
+
+	/* styles used only in the removed lines */
+	rec->lines_removed += lines;
+	g_hash_table_foreach_remove(rec->used, (GHRFunc) style_window_release,
+				    &rec->lines_removed);
+}
+
+static void style_window_destroy(WindowGui *window, StyleWindow *rec)
+{
+	g_hash_table_foreach_remove(rec->used, (GHRFunc) style_window_release,
+				    NULL);
+	g_hash_table_destroy(rec->used);
+	g_free(rec);
+}
+
+static void sig_gui_window_destroyed(WindowGui *window)
+{
+	StyleWindow *rec;
+
+	rec = g_hash_table_lookup(style_windows, window);
+	if (rec != NULL) {
+		g_hash_table_remove(style_windows, window);
+		style_window_destroy(window, rec);
+	}
+}
+
+static void sig_gui_stats(Window *window)
+{
+	printtext_window(window, MSGLEVEL_CLIENTNOTICE,
+			 "Style tags: %d (%d unused), %lu created, "
+			 "%lu reused, %lu destroyed",
+			 g_hash_table_size(styles), idle_styles->length,
+			 style_stats.created, style_stats.reused,
+			 style_stats.destroyed);
+}
+
+static int style_free(Style *style)
+{
+	g_free(style);
+	return TRUE;
+}
+
+void gui_styles_init(void)
+{
+	gui_colors_init();
+
+	tag_table = gtk_text_tag_table_new();
+	styles = g_hash_table_new((GHashFunc) style_hash,
+				  (GCompareFunc) style_equal);
+	idle_styles = g_queue_new();
+	style_windows = g_hash_table_new((GHashFunc) g_direct_hash,
+					 (GCompareFunc) g_direct_equal);
+	memset(&style_stats, 0, sizeof(style_stats));
+
+	settings_add_int("lookandfeel", "gui_style_tags_max", 256);
+
+	signal_add("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+	signal_add("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
+
+void gui_styles_deinit(void)
+{
+	g_hash_table_foreach(style_windows, (GHFunc) style_window_destroy,
+			     NULL);
+	g_hash_table_destroy(style_windows);
+
+	g_hash_table_foreach_remove(styles, (GHRFunc) style_free, NULL);
+	g_hash_table_destroy(styles);
+	g_queue_free(idle_styles);
+	g_object_unref(G_OBJECT(tag_table));
+
+	signal_remove("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+	signal_remove("gui stats", (SIGNAL_FUNC) sig_gui_stats);
+}
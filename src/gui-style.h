@@ -0,0 +1,17 @@
+#ifndef __GUI_STYLE_H
+#define __GUI_STYLE_H
+
+/* Tag table shared by all the window buffers. */
+GtkTextTagTable *gui_style_tag_table(void);
+
+/* Returns the tag for text printed with the given colors and flags to
+   the line in window, or NULL if it doesn't need one. */
+GtkTextTag *gui_style_get(WindowGui *window, int line,
+			  int fg, int bg, int flags);
+/* The first lines were removed from the window. */
+void gui_style_window_trim(WindowGui *window, int lines);
+
+void gui_styles_init(void);
+void gui_styles_deinit(void);
+
+#endif
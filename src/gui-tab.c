@@ -21,6 +21,7 @@
 #include "module.h"
 #include "signals.h"
 
+#include "gui-burst.h"
 #include "gui-frame.h"
 #include "gui-tab.h"
 #include "gui-tab-move.h"
@@ -30,6 +31,8 @@
 #include "gui-window.h"
 #include "gui-window-view.h"
 
+extern char *window_get_label(Window *window);
+
 #include "move.xpm"
 #include "right.xpm"
 
@@ -70,10 +73,13 @@ static gboolean event_destroy(GtkWidget *window, Tab *tab)
 	   short time it takes for frame to notice the tab change. */
 	if (tab->frame->active_tab == tab)
 		tab->frame->active_tab = NULL;
+	if (tab->frame->prev_tab == tab)
+		tab->frame->prev_tab = NULL;
 
 	gui_reset_tab_labels(tab->frame);
 
 	g_object_set_data(G_OBJECT(tab->widget), "Tab", NULL);
+	g_free(tab->label_text);
 	g_free(tab);
 	return FALSE;
 }
@@ -105,10 +111,8 @@ static GtkWidget *gui_tab_label_new(GtkWidget *label, Tab *tab)
 static void gui_tab_set_label(Tab *tab)
 {
 	char str[20];
-	int page_num;
 
-        page_num = gtk_notebook_page_num(tab->frame->notebook, tab->widget)+1;
-	g_snprintf(str, sizeof(str), "%d:", page_num);
+	g_snprintf(str, sizeof(str), "%d:", tab->page+1);
 	gtk_label_set_text(tab->label, str);
 }
 
@@ -131,6 +135,7 @@ Tab *gui_tab_new(Frame *frame)
 	gtk_container_set_border_width(GTK_CONTAINER(vbox), 5);
 
 	hpane = gtk_hpaned_new();
+	tab->main_paned = GTK_PANED(hpane);
 	gtk_box_pack_start(GTK_BOX(vbox), hpane, TRUE, TRUE, 0);
 
 	/* tab's label */
@@ -153,21 +158,38 @@ Tab *gui_tab_new(Frame *frame)
 	gtk_paned_pack1(GTK_PANED(hpane), vpane, TRUE, TRUE);
 	tab->first_paned = tab->last_paned = GTK_PANED(vpane);
 
-	/* nicklist */
-	tab->nicklist = gui_nicklist_view_new(tab);
-	gtk_paned_pack2(GTK_PANED(hpane), tab->nicklist->widget, FALSE, TRUE);
-
 	gtk_widget_show_all(vbox);
-	gtk_widget_hide(tab->nicklist->widget);
 
-	gtk_notebook_append_page(frame->notebook, tab->widget,
-				 tab->tab_label_widget);
+	tab->page = gtk_notebook_append_page(frame->notebook, tab->widget,
+					     tab->tab_label_widget);
 	gui_tab_set_label(tab);
 
 	signal_emit("gui tab created", 1, tab);
 	return tab;
 }
 
+void gui_tab_realize(Tab *tab)
+{
+	GList *tmp;
+
+	if (tab->realized || tab->destroying)
+		return;
+	tab->realized = TRUE;
+
+	/* nicklist */
+	tab->nicklist = gui_nicklist_view_new(tab);
+	gtk_paned_pack2(tab->main_paned, tab->nicklist->widget, FALSE, TRUE);
+
+	for (tmp = tab->panes; tmp != NULL; tmp = tmp->next) {
+		TabPane *pane = tmp->data;
+
+		if (pane->view != NULL)
+			gui_window_view_realize(pane->view);
+	}
+
+	gui_tab_set_active_window_item(tab, tab->active_win);
+}
+
 static void event_pane_close(GtkWidget *widget, TabPane *pane)
 {
 	if (windows->next != NULL)
@@ -282,8 +304,17 @@ static gboolean event_notify_pane(GtkWidget *widget, GParamSpec *spec,
 
 	if (strcmp(spec->name, "parent") == 0) {
 		tab = gui_widget_find_data(widget, "Tab");
-		if (tab != NULL)
+		if (tab != NULL && tab != pane->tab) {
+			/* pane moved to another tab */
+			if (pane->view != NULL)
+				gui_tab_remove_view(pane->tab, pane->view);
 			pane->tab = tab;
+			if (pane->view != NULL) {
+				gui_tab_add_view(tab, pane->view);
+				if (tab->realized)
+					gui_window_view_realize(pane->view);
+			}
+		}
 	}
 	return FALSE;
 }
@@ -421,13 +452,10 @@ Tab *gui_tab_get_page(Frame *frame, int page)
 
 void gui_tab_set_active(Tab *tab)
 {
-	int page;
-
 	if (tab->frame->destroying)
 		return;
 
-	page = gtk_notebook_page_num(tab->frame->notebook, tab->widget);
-	gtk_notebook_set_current_page(tab->frame->notebook, page);
+	gtk_notebook_set_current_page(tab->frame->notebook, tab->page);
 
 	gui_frame_set_active_window(tab->frame, tab->active_win);
 }
@@ -445,8 +473,10 @@ void gui_tab_set_active_window(Tab *tab, Window *window)
 				pane->focused = FALSE;
 				gui_tab_set_focus_colors(pane->focus_widget,
 							 FALSE);
-				gui_tab_set_focus_colors(pane->view->title,
-							 FALSE);
+				if (pane->view->title != NULL) {
+					gui_tab_set_focus_colors(pane->view->title,
+								 FALSE);
+				}
 				signal_emit("tab pane unfocused", 1, pane);
 			}
 		}
@@ -455,11 +485,13 @@ void gui_tab_set_active_window(Tab *tab, Window *window)
 
 			pane->focused = TRUE;
 			gui_tab_set_focus_colors(pane->focus_widget, TRUE);
-			gui_tab_set_focus_colors(pane->view->title, TRUE);
+			if (pane->view->title != NULL)
+				gui_tab_set_focus_colors(pane->view->title, TRUE);
 			signal_emit("tab pane focused", 1, pane);
 		}
 
 		tab->active_win = window;
+		gui_tab_update_label_text(tab);
 		gui_tab_set_active_window_item(tab, window);
 	}
 
@@ -467,14 +499,48 @@ void gui_tab_set_active_window(Tab *tab, Window *window)
 		gui_frame_set_active_window(tab->frame, window);
 }
 
+/* Guess the views' new widths after the nicklist was shown or hidden,
+   so text printed before GTK gets to resize them is wrapped right.
+   size_allocate gives the real widths later. */
+static void tab_predict_widths(Tab *tab, int nicklist_shown)
+{
+	GtkWidget *nicklist;
+	GList *tmp;
+	int diff, handle_size, width;
+
+	nicklist = tab->nicklist->widget;
+	gtk_widget_style_get(GTK_WIDGET(tab->main_paned), "handle_size",
+			     &handle_size, NULL);
+	diff = (nicklist->allocation.width > 1 ?
+		nicklist->allocation.width :
+		nicklist->requisition.width) + handle_size;
+	if (nicklist_shown)
+		diff = -diff;
+
+	for (tmp = tab->panes; tmp != NULL; tmp = tmp->next) {
+		TabPane *pane = tmp->data;
+		WindowView *view = pane->view;
+
+		if (view == NULL || !view->realized || view->font_width <= 0)
+			continue;
+
+		width = GTK_WIDGET(view->view)->allocation.width + diff;
+		view->approx_width = MAX(width, 0) / view->font_width;
+		gui_window_update_width(view->window);
+	}
+}
+
 void gui_tab_set_active_window_item(Tab *tab, Window *window)
 {
 	WindowItem *witem;
 	ChannelGui *gui;
+	int visible;
 
-	if (tab->destroying)
+	if (tab->destroying || tab->nicklist == NULL)
 		return;
 
+	visible = GTK_WIDGET_VISIBLE(tab->nicklist->widget) != 0;
+
 	witem = window == NULL ? NULL : window->active;
 	if (!IS_CHANNEL(witem)) {
 		/* clear nicklist */
@@ -486,9 +552,9 @@ void gui_tab_set_active_window_item(Tab *tab, Window *window)
 		gtk_widget_show(tab->nicklist->widget);
 	}
 
-	/* make sure the windows know their new size,
-	   before new text is printed */
-	gtk_container_check_resize(GTK_CONTAINER(tab->frame->widget));
+	/* the relayout itself is left to GTK's idle resize */
+	if (visible != (IS_CHANNEL(witem) != 0))
+		tab_predict_widths(tab, !visible);
 }
 
 void gui_tab_update_active_window(Tab *tab)
@@ -515,16 +581,123 @@ void gui_tab_update_active_window(Tab *tab)
         gui_tab_set_active_window(tab, window);
 }
 
+static void tab_update_data_level(Tab *tab)
+{
+	int level;
+
+	for (level = DATA_LEVEL_HILIGHT; level > 0; level--) {
+		if (tab->activity[level] > 0)
+			break;
+	}
+	tab->data_level = level;
+}
+
+static int view_get_data_level(WindowView *view)
+{
+	return CLAMP(view->window->window->data_level,
+		     0, DATA_LEVEL_HILIGHT);
+}
+
+void gui_tab_add_view(Tab *tab, WindowView *view)
+{
+	if (tab->visible)
+		view->window->visible++;
+
+	view->data_level = view_get_data_level(view);
+	tab->activity[view->data_level]++;
+	tab_update_data_level(tab);
+}
+
+void gui_tab_remove_view(Tab *tab, WindowView *view)
+{
+	if (tab->visible)
+		view->window->visible--;
+
+	tab->activity[view->data_level]--;
+	tab_update_data_level(tab);
+}
+
+void gui_tab_set_visible(Tab *tab, int visible)
+{
+	GList *tmp;
+
+	if (tab->visible == visible)
+		return;
+
+	if (visible)
+		gui_tab_realize(tab);
+
+	tab->visible = visible;
+	for (tmp = tab->panes; tmp != NULL; tmp = tmp->next) {
+		TabPane *pane = tmp->data;
+
+		if (pane->view != NULL)
+			pane->view->window->visible += visible ? 1 : -1;
+	}
+}
+
+void gui_tab_update_activity(Tab *tab, WindowView *view)
+{
+	int data_level;
+
+	data_level = view_get_data_level(view);
+	if (data_level == view->data_level)
+		return;
+
+	tab->activity[view->data_level]--;
+	tab->activity[data_level]++;
+	view->data_level = data_level;
+	tab_update_data_level(tab);
+}
+
+static void frame_set_tab_labels(Frame *frame)
+{
+	GList *list, *tmp;
+	Tab *tab;
+
+	list = gtk_container_get_children(GTK_CONTAINER(frame->notebook));
+	for (tmp = list; tmp != NULL; tmp = tmp->next) {
+		tab = g_object_get_data(G_OBJECT(tmp->data), "Tab");
+		if (tab != NULL)
+			gui_tab_set_label(tab);
+	}
+	g_list_free(list);
+}
+
 void gui_reset_tab_labels(Frame *frame)
 {
+	GList *list, *tmp;
 	Tab *tab;
-	int i;
+	int page;
 
-	i = 0;
-	while ((tab = gui_tab_get_page(frame, i)) != NULL) {
-                gui_tab_set_label(tab);
-		i++;
+	/* page numbers are needed right away for switching */
+	list = gtk_container_get_children(GTK_CONTAINER(frame->notebook));
+	for (tmp = list, page = 0; tmp != NULL; tmp = tmp->next, page++) {
+		tab = g_object_get_data(G_OBJECT(tmp->data), "Tab");
+		if (tab != NULL)
+			tab->page = page;
 	}
+	g_list_free(list);
+
+	if (!gui_burst_defer((GuiBurstFunc) frame_set_tab_labels, frame))
+		frame_set_tab_labels(frame);
+}
+
+void gui_tab_update_label_text(Tab *tab)
+{
+	char *str;
+
+	str = tab->active_win == NULL ? NULL :
+		window_get_label(tab->active_win);
+	if (str != NULL && tab->label_text != NULL &&
+	    strcmp(str, tab->label_text) == 0) {
+		g_free(str);
+		return;
+	}
+
+	g_free(tab->label_text);
+	tab->label_text = str;
+	signal_emit("gui tab label changed", 1, tab);
 }
 
 void gui_tab_set_focus_colors(GtkWidget *widget, int focused)
@@ -9,13 +9,21 @@ struct _Tab {
 	GtkLabel *label;
 	GtkBox *tab_label_box;
 
+	GtkPaned *main_paned; /* windows | nicklist */
 	GtkPaned *first_paned, *last_paned;
 	GList *panes;
 
 	NicklistView *nicklist;
 	Window *active_win;
 	int data_level;
+	int activity[4]; /* number of views in each data level */
 
+	/* cached so switching doesn't need to walk the notebook */
+	int page; /* position in notebook, updated by gui_reset_tab_labels() */
+	char *label_text; /* window_get_label() of active_win */
+
+	unsigned int visible:1; /* active tab in its frame */
+	unsigned int realized:1; /* nicklist and views have been built */
 	unsigned int destroying:1;
 };
 
@@ -30,7 +38,10 @@ struct _TabPane {
 	unsigned int focused:1;
 };
 
+/* Only the panes are created here, the nicklist and window views are
+   built by gui_tab_realize() when the tab is first shown. */
 Tab *gui_tab_new(Frame *frame);
+void gui_tab_realize(Tab *tab);
 
 GtkPaned *gui_tab_add_paned(Tab *tab);
 TabPane *gui_tab_pane_new(Tab *tab);
@@ -43,7 +54,20 @@ void gui_tab_set_active_window(Tab *tab, Window *window);
 void gui_tab_set_active_window_item(Tab *tab, Window *window);
 void gui_tab_update_active_window(Tab *tab);
 
+/* keep the tab's visibility and activity counters in sync with the
+   views in it */
+void gui_tab_add_view(Tab *tab, WindowView *view);
+void gui_tab_remove_view(Tab *tab, WindowView *view);
+void gui_tab_set_visible(Tab *tab, int visible);
+/* view's window data level changed */
+void gui_tab_update_activity(Tab *tab, WindowView *view);
+
+/* update the tabs' page numbers and labels after tabs were added,
+   removed or moved */
 void gui_reset_tab_labels(Frame *frame);
+/* active window's label changed, emits "gui tab label changed"
+   if it really did */
+void gui_tab_update_label_text(Tab *tab);
 void gui_tab_set_focus_colors(GtkWidget *widget, int focused);
 
 void gui_tabs_init(void);
@@ -45,48 +45,24 @@ static void sig_activity(Window *window)
 		item->hilight_color = 0;
 	}
 
-	signal_stop();
-}
-
-static void tab_update_activity(Tab *tab)
-{
-	GList *tmp;
-	int data_level;
-
-	/* get highest data level */
-	data_level = 0;
-	for (tmp = tab->panes; tmp != NULL; tmp = tmp->next) {
-		TabPane *pane = tmp->data;
+	for (tmp = WINDOW_GUI(window)->views; tmp != NULL; tmp = tmp->next) {
+		WindowView *view = tmp->data;
 
-		if (pane->view != NULL &&
-		    pane->view->window->window->data_level > data_level)
-			data_level = pane->view->window->window->data_level;
+		gui_tab_update_activity(view->pane->tab, view);
 	}
-	tab->data_level = data_level;
-}
 
-static void tab_clear_activity(Tab *tab)
-{
-	tab->data_level = 0;
+	signal_stop();
 }
 
 static void sig_activity_update(Window *window)
 {
 	GSList *tmp;
 
+	/* update tab's main label's color too */
 	for (tmp = WINDOW_GUI(window)->views; tmp != NULL; tmp = tmp->next) {
 		WindowView *view = tmp->data;
 
-		if (window->data_level == 0) {
-			if (view->pane->tab->data_level != 0)
-				tab_clear_activity(view->pane->tab);
-			continue;
-		}
-
-		if (view->pane->tab->data_level < window->data_level) {
-			/* update tab's main label's color too */
-			tab_update_activity(view->pane->tab);
-		}
+		gui_tab_update_activity(view->pane->tab, view);
 	}
 }
 
@@ -26,6 +26,7 @@
 
 #include "formats.h"
 
+#include "gui-print-worker.h"
 #include "gui-window.h"
 #include "gui-window-view.h"
 #include "gui-window-context.h"
@@ -176,52 +177,56 @@ GtkTextTag *gui_window_context_create_tag(WindowGui *window, const char *name)
 	return tag;
 }
 
-void gui_window_print_mark_context(WindowGui *window, TextDest *dest,
-				   GtkTextIter *iter, const char *text)
+void gui_window_print_mark_context(WindowGui *window, Channel *channel,
+				   GtkTextIter *iter, const char *text,
+				   GArray *words)
 {
 	GtkTextIter start_iter, end_iter;
-	GtkTextTag *tag;
-	Channel *channel;
-	const char *start;
+	GtkTextTag *tag, *style;
+	TextWord *rec;
 	char *word;
-	int len, line, index;
-
-	channel = dest == NULL || dest->server == NULL ||
-		dest->target == NULL ? NULL :
-		channel_find(dest->server, dest->target);
+	int i, len, line, index;
+
+	if (words == NULL) {
+		/* not split by the print workers */
+		words = gui_text_split_words(text);
+		gui_window_print_mark_context(window, channel, iter,
+					      text, words);
+		g_array_free(words, TRUE);
+		return;
+	}
 
 	/* mark context words if there's any */
+	len = strlen(text);
 	line = gtk_text_iter_get_line(iter);
 	index = gtk_text_iter_get_line_index(iter);
-	for (start = text; ; text++) {
-		if (*text != '\0' && *text != '\t' && *text != ' ' && *text != '\r' && *text != '\n')
-			continue;
-
-		if (text == start)
-			len = 0;
-		else {
-			/* got a word */
-			word = g_strndup(start, (int) (text-start));
-			len = strlen(word);
-
-			tag = NULL;
-			signal_emit("gui window context word", 4,
-				    &tag, window, channel, word);
-			g_free(word);
-
-			if (tag != NULL) {
-				/* apply the context tag */
-				gtk_text_buffer_get_iter_at_line_index(window->buffer, &start_iter, line, index);
-				gtk_text_buffer_get_iter_at_line_index(window->buffer, &end_iter, line, index+len);
-				gtk_text_buffer_apply_tag(window->buffer, tag,
-							  &start_iter, &end_iter);
-			}
-		}
+	for (i = 0; i < (int)words->len; i++) {
+		rec = &g_array_index(words, TextWord, i);
 
-		if (*text == '\0')
+		/* the text may have been cut after splitting */
+		if (rec->start + rec->len > len)
 			break;
-		start = text+1;
-		index += len+1;
+
+		word = gui_arena_strndup(window->arena, text + rec->start,
+					 rec->len);
+		tag = style = NULL;
+		signal_emit("gui window context word", 5,
+			    &tag, window, channel, word, &style);
+
+		if (tag != NULL || style != NULL) {
+			gtk_text_buffer_get_iter_at_line_index(window->buffer, &start_iter, line, index + rec->start);
+			gtk_text_buffer_get_iter_at_line_index(window->buffer, &end_iter, line, index + rec->start + rec->len);
+		}
+		if (tag != NULL) {
+			/* apply the context tag */
+			gtk_text_buffer_apply_tag(window->buffer, tag,
+						  &start_iter, &end_iter);
+		}
+		if (style != NULL) {
+			/* and how the word should look */
+			gtk_text_buffer_apply_tag(window->buffer, style,
+						  &start_iter, &end_iter);
+		}
 	}
 }
 
@@ -269,7 +274,7 @@ gboolean gui_window_context_event_motion(GtkWidget *widget, GdkEvent *event,
 	return FALSE;
 }
 
-static void sig_gui_window_view_created(WindowView *view)
+static void sig_gui_window_view_realized(WindowView *view)
 {
         ContextEvent *context;
 
@@ -282,6 +287,9 @@ static void sig_gui_window_view_destroyed(WindowView *view)
 {
         ContextEvent *context;
 
+	if (view->view == NULL)
+		return;
+
 	context = g_object_get_data(G_OBJECT(view->view), "context");
 	g_free(context->word);
 	g_free(context);
@@ -291,7 +299,7 @@ void gui_window_contexts_init(void)
 {
 	hand_cursor = gdk_cursor_new(GDK_HAND2);
 
-	signal_add("gui window view created", (SIGNAL_FUNC) sig_gui_window_view_created);
+	signal_add("gui window view realized", (SIGNAL_FUNC) sig_gui_window_view_realized);
 	signal_add("gui window view destroyed", (SIGNAL_FUNC) sig_gui_window_view_destroyed);
 }
 
@@ -299,6 +307,6 @@ void gui_window_contexts_deinit(void)
 {
 	gdk_cursor_unref(hand_cursor);
 
-	signal_remove("gui window view created", (SIGNAL_FUNC) sig_gui_window_view_created);
+	signal_remove("gui window view realized", (SIGNAL_FUNC) sig_gui_window_view_realized);
 	signal_remove("gui window view destroyed", (SIGNAL_FUNC) sig_gui_window_view_destroyed);
 }
@@ -3,8 +3,10 @@
 
 GtkTextTag *gui_window_context_create_tag(WindowGui *window, const char *name);
 
-void gui_window_print_mark_context(WindowGui *window, TextDest *dest,
-				   GtkTextIter *iter, const char *text);
+/* words are TextWord spans in text, NULL if they're not known yet */
+void gui_window_print_mark_context(WindowGui *window, Channel *channel,
+				   GtkTextIter *iter, const char *text,
+				   GArray *words);
 
 /* motion_notify_event handler */
 gboolean gui_window_context_event_motion(GtkWidget *widget, GdkEvent *event,
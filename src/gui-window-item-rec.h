@@ -1 +1,3 @@
 GtkWidget *(*get_title)(WindowView *view, WindowItem *item);
+/* called when a cached title is shown again */
+void (*update_title)(WindowView *view, WindowItem *item, GtkWidget *title);
@@ -0,0 +1,361 @@
+/*
+ gui-window-lines.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "commands.h"
+#include "levels.h"
+
+#include "printtext.h"
+
+#include "gui-window.h"
+#include "gui-window-lines.h"
+
+typedef struct {
+	GArray *lines; /* LineInfo, oldest first */
+	int lines_removed; /* to get absolute line numbers */
+
+	LineInfo pending; /* line being printed */
+	unsigned int pending_set:1;
+
+	int filter; /* hidden levels */
+	GtkTextTag *hidden_tag;
+} WindowLines;
+
+typedef struct {
+	char *nick;
+	int refs; /* lines with it */
+} LineNick;
+
+static GHashTable *window_lines; /* WindowGui => WindowLines */
+static GHashTable *nick_ids; /* nick => id */
+static GPtrArray *nicks; /* id => LineNick, NULL if unused */
+static GArray *free_nick_ids;
+
+static int nick_ref(const char *nick)
+{
+	LineNick *rec;
+	void *value;
+	int id;
+
+	if (nick == NULL)
+		return 0;
+
+	if (g_hash_table_lookup_extended(nick_ids, nick, NULL, &value)) {
+		id = GPOINTER_TO_INT(value);
+		rec = g_ptr_array_index(nicks, id);
+		rec->refs++;
+		return id;
+	}
+
+	rec = g_new0(LineNick, 1);
+	rec->nick = g_strdup(nick);
+	rec->refs = 1;
+
+	if (free_nick_ids->len > 0) {
+		id = g_array_index(free_nick_ids, int, free_nick_ids->len-1);
+		g_array_set_size(free_nick_ids, free_nick_ids->len-1);
+		g_ptr_array_index(nicks, id) = rec;
+	} else {
+		/* id 0 is "no nick" */
+		if (nicks->len == 0)
+			g_ptr_array_add(nicks, NULL);
+		id = nicks->len;
+		g_ptr_array_add(nicks, rec);
+	}
+	g_hash_table_insert(nick_ids, rec->nick, GINT_TO_POINTER(id));
+	return id;
+}
+
+static void nick_unref(int id)
+{
+	LineNick *rec;
+
+	if (id == 0)
+		return;
+
+	rec = g_ptr_array_index(nicks, id);
+	if (--rec->refs > 0)
+		return;
+
+	g_hash_table_remove(nick_ids, rec->nick);
+	g_ptr_array_index(nicks, id) = NULL;
+	g_array_append_val(free_nick_ids, id);
+	g_free(rec->nick);
+	g_free(rec);
+}
+
+static void lines_unref_nicks(GArray *lines, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		nick_unref(g_array_index(lines, LineInfo, i).nick_id);
+}
+
+const char *gui_window_lines_nick(int id)
+{
+	LineNick *rec;
+
+	if (id <= 0 || id >= (int)nicks->len)
+		return NULL;
+
+	rec = g_ptr_array_index(nicks, id);
+	return rec == NULL ? NULL : rec->nick;
+}
+
+static WindowLines *window_lines_get(WindowGui *window)
+{
+	WindowLines *rec;
+
+	rec = g_hash_table_lookup(window_lines, window);
+	if (rec == NULL) {
+		rec = g_new0(WindowLines, 1);
+		rec->lines = g_array_new(FALSE, FALSE, sizeof(LineInfo));
+		g_hash_table_insert(window_lines, window, rec);
+	}
+	return rec;
+}
+
+void gui_window_lines_fragment(WindowGui *window, int line, time_t time,
+			       int level, const char *nick, int hilight)
+{
+	WindowLines *rec;
+
+	rec = window_lines_get(window);
+	if (rec->pending_set)
+		return;
+
+	/* the first fragment tells what the line is */
+	rec->pending.line = line + rec->lines_removed;
+	rec->pending.time = time;
+	rec->pending.level = level;
+	rec->pending.nick_id = nick_ref(nick);
+	rec->pending.hilight = hilight;
+	rec->pending_set = TRUE;
+}
+
+/* from the newline before the line, so hidden lines leave no gaps */
+static void line_get_iter(WindowGui *window, WindowLines *rec,
+			  GtkTextIter *iter, int pos)
+{
+	int line;
+
+	if (pos >= (int)rec->lines->len) {
+		gtk_text_buffer_get_end_iter(window->buffer, iter);
+		return;
+	}
+
+	line = g_array_index(rec->lines, LineInfo, pos).line -
+		rec->lines_removed;
+	gtk_text_buffer_get_iter_at_line(window->buffer, iter,
+					 line < 0 ? 0 : line);
+	if (line > 0)
+		gtk_text_iter_backward_char(iter);
+}
+
+static void lines_hide(WindowGui *window, WindowLines *rec,
+		       int first, int last)
+{
+	GtkTextIter start_iter, end_iter;
+
+	if (rec->hidden_tag == NULL) {
+		rec->hidden_tag = gtk_text_buffer_create_tag(window->buffer,
+							     NULL, NULL);
+		g_object_set(G_OBJECT(rec->hidden_tag), "invisible", TRUE,
+			     NULL);
+	}
+
+	line_get_iter(window, rec, &start_iter, first);
+	line_get_iter(window, rec, &end_iter, last+1);
+	gtk_text_buffer_apply_tag(window->buffer, rec->hidden_tag,
+				  &start_iter, &end_iter);
+}
+
+void gui_window_lines_finished(WindowGui *window, int dropped)
+{
+	WindowLines *rec;
+
+	rec = g_hash_table_lookup(window_lines, window);
+	if (rec == NULL || !rec->pending_set)
+		return;
+
+	rec->pending_set = FALSE;
+	if (dropped) {
+		nick_unref(rec->pending.nick_id);
+		return;
+	}
+
+	g_array_append_val(rec->lines, rec->pending);
+	if (rec->filter & rec->pending.level)
+		lines_hide(window, rec, rec->lines->len-1, rec->lines->len-1);
+}
+
+void gui_window_lines_trim(WindowGui *window, int lines)
+{
+	WindowLines *rec;
+	int count;
+
+	rec = g_hash_table_lookup(window_lines, window);
+	if (rec == NULL)
+		return;
+
+	/* drop the lines that are completely gone */
+	rec->lines_removed += lines;
+	for (count = 0; count+1 < (int)rec->lines->len; count++) {
+		if (g_array_index(rec->lines, LineInfo, count+1).line >
+		    rec->lines_removed)
+			break;
+	}
+	if (count > 0) {
+		lines_unref_nicks(rec->lines, count);
+		g_array_remove_range(rec->lines, 0, count);
+	}
+}
+
+void gui_window_lines_set_filter(WindowGui *window, int filter)
+{
+	GtkTextIter start_iter, end_iter;
+	WindowLines *rec;
+	int i, first;
+
+	rec = window_lines_get(window);
+	rec->filter = filter;
+
+	if (rec->hidden_tag != NULL) {
+		gtk_text_buffer_get_bounds(window->buffer,
+					   &start_iter, &end_iter);
+		gtk_text_buffer_remove_tag(window->buffer, rec->hidden_tag,
+					   &start_iter, &end_iter);
+	}
+	if (filter == 0)
+		return;
+
+	/* hide the runs of filtered lines, the text itself isn't touched */
+	first = -1;
+	for (i = 0; i <= (int)rec->lines->len; i++) {
+		if (i < (int)rec->lines->len &&
+		    (g_array_index(rec->lines, LineInfo, i).level & filter)) {
+			if (first == -1)
+				first = i;
+		} else if (first != -1) {
+			lines_hide(window, rec, first, i-1);
+			first = -1;
+		}
+	}
+}
+
+int gui_window_lines_get_filter(WindowGui *window)
+{
+	WindowLines *rec;
+
+	rec = g_hash_table_lookup(window_lines, window);
+	return rec == NULL ? 0 : rec->filter;
+}
+
+GtkTextTag *gui_window_lines_last_hidden(WindowGui *window)
+{
+	WindowLines *rec;
+
+	rec = g_hash_table_lookup(window_lines, window);
+	if (rec == NULL || rec->lines->len == 0)
+		return NULL;
+
+	return (rec->filter & g_array_index(rec->lines, LineInfo,
+					    rec->lines->len-1).level) == 0 ?
+		NULL : rec->hidden_tag;
+}
+
+GArray *gui_window_lines_get(WindowGui *window)
+{
+	return window_lines_get(window)->lines;
+}
+
+static void window_lines_free(WindowGui *window, WindowLines *rec)
+{
+	if (rec->hidden_tag != NULL) {
+		gtk_text_tag_table_remove(window->tagtable,
+					  rec->hidden_tag);
+	}
+	lines_unref_nicks(rec->lines, rec->lines->len);
+	if (rec->pending_set)
+		nick_unref(rec->pending.nick_id);
+	g_array_free(rec->lines, TRUE);
+	g_free(rec);
+}
+
+static void sig_gui_window_destroyed(WindowGui *window)
+{
+	WindowLines *rec;
+
+	rec = g_hash_table_lookup(window_lines, window);
+	if (rec != NULL) {
+		g_hash_table_remove(window_lines, window);
+		window_lines_free(window, rec);
+	}
+}
+
+/* SYNTAX: GUI FILTER [<levels>|NONE] */
+static void cmd_gui_filter(const char *data)
+{
+	WindowGui *window;
+	char *levels;
+	int filter;
+
+	window = WINDOW_GUI(active_win);
+	if (*data != '\0') {
+		filter = g_ascii_strcasecmp(data, "NONE") == 0 ? 0 :
+			level2bits(data);
+		gui_window_lines_set_filter(window, filter);
+	}
+
+	filter = gui_window_lines_get_filter(window);
+	levels = bits2level(filter);
+	printtext_window(active_win, MSGLEVEL_CLIENTNOTICE,
+			 "Hidden levels in this window: %s",
+			 filter == 0 ? "none" : levels);
+	g_free(levels);
+}
+
+void gui_window_lines_init(void)
+{
+	window_lines = g_hash_table_new((GHashFunc) g_direct_hash,
+					(GCompareFunc) g_direct_equal);
+	nick_ids = g_hash_table_new((GHashFunc) g_str_hash,
+				    (GCompareFunc) g_str_equal);
+	nicks = g_ptr_array_new();
+	free_nick_ids = g_array_new(FALSE, FALSE, sizeof(int));
+
+	signal_add("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+	command_bind("gui filter", NULL, (SIGNAL_FUNC) cmd_gui_filter);
+}
+
+void gui_window_lines_deinit(void)
+{
+	g_hash_table_foreach(window_lines, (GHFunc) window_lines_free, NULL);
+	g_hash_table_destroy(window_lines);
+	g_hash_table_destroy(nick_ids);
+	g_ptr_array_free(nicks, TRUE);
+	g_array_free(free_nick_ids, TRUE);
+
+	signal_remove("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+	command_unbind("gui filter", (SIGNAL_FUNC) cmd_gui_filter);
+}
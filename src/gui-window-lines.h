@@ -0,0 +1,40 @@
+#ifndef __GUI_WINDOW_LINES_H
+#define __GUI_WINDOW_LINES_H
+
+/* What each line in a window is, so the lines can be filtered without
+   parsing the text. */
+typedef struct {
+	int line; /* first line in buffer, counting the removed ones */
+	time_t time;
+	int level;
+	int nick_id; /* 0 if not from a nick */
+	unsigned int hilight:1;
+} LineInfo;
+
+/* Nick of LineInfo's nick_id. The ids are valid as long as some line
+   still has them. */
+const char *gui_window_lines_nick(int id);
+
+/* Text was printed to line in buffer. The first fragment of each line
+   gives its information. */
+void gui_window_lines_fragment(WindowGui *window, int line, time_t time,
+			       int level, const char *nick, int hilight);
+/* The line is finished, or dropped if it wasn't added after all. */
+void gui_window_lines_finished(WindowGui *window, int dropped);
+/* The first lines were removed from the window. */
+void gui_window_lines_trim(WindowGui *window, int lines);
+
+/* LineInfo array of window, oldest first */
+GArray *gui_window_lines_get(WindowGui *window);
+
+/* Hide lines with any of the levels in filter, 0 shows everything. */
+void gui_window_lines_set_filter(WindowGui *window, int filter);
+int gui_window_lines_get_filter(WindowGui *window);
+/* Tag hiding the last line of window, NULL if it's shown. Text added
+   to the end of the line needs it too. */
+GtkTextTag *gui_window_lines_last_hidden(WindowGui *window);
+
+void gui_window_lines_init(void);
+void gui_window_lines_deinit(void);
+
+#endif
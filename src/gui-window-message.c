@@ -0,0 +1,214 @@
+/*
+ gui-window-message.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "servers.h"
+#include "levels.h"
+
+#include "printtext.h"
+
+#include "gui-window-message.h"
+
+/* set by the message signals, which may be stopped before the text is
+   printed or before our last handler runs. so the lines are also
+   checked to be of the message, and it's forgotten when its line is
+   finished. */
+static GuiMessage *current;
+static int current_printed;
+static int current_once; /* FALSE if printed to several windows */
+
+static void message_clear(void)
+{
+	if (current == NULL)
+		return;
+
+	g_free(current->target);
+	g_free(current->nick);
+	g_free(current->reason);
+	g_free(current->key);
+	g_free(current);
+	current = NULL;
+}
+
+static GuiMessage *message_start(Server *server, const char *target,
+				 const char *nick, int level)
+{
+	message_clear();
+
+	current = g_new0(GuiMessage, 1);
+	current->server = server;
+	current->target = g_strdup(target);
+	current->nick = g_strdup(nick);
+	current->level = level;
+	current_printed = FALSE;
+	current_once = TRUE;
+	return current;
+}
+
+static void message_set_key(const char *msg, const char *suffix)
+{
+	current->key = g_strconcat(current->server->tag, " ",
+				   current->target == NULL ? "" :
+				   current->target, " ", current->nick,
+				   " ", msg, suffix, NULL);
+}
+
+GuiMessage *gui_window_message_get(TEXT_DEST_REC *dest)
+{
+	if (current == NULL || dest == NULL ||
+	    dest->server != current->server ||
+	    (dest->level & current->level) == 0)
+		return NULL;
+
+	if (current->target != NULL && dest->target != NULL &&
+	    g_ascii_strcasecmp(current->target, dest->target) != 0)
+		return NULL;
+
+	current_printed = TRUE;
+	return current;
+}
+
+void gui_window_message_finished(void)
+{
+	if (current_printed && current_once)
+		message_clear();
+}
+
+/* private messages are printed to the sender's query */
+static const char *message_target(Server *server, const char *target,
+				  const char *nick)
+{
+	return target == NULL || server->nick == NULL ||
+		g_ascii_strcasecmp(target, server->nick) == 0 ?
+		nick : target;
+}
+
+static void sig_message_public(Server *server, const char *msg,
+			       const char *nick, const char *address,
+			       const char *target)
+{
+	message_start(server, target, nick, MSGLEVEL_PUBLIC);
+	message_set_key(msg, "");
+}
+
+static void sig_message_private(Server *server, const char *msg,
+				const char *nick, const char *address)
+{
+	message_start(server, nick, nick, MSGLEVEL_MSGS);
+	message_set_key(msg, "");
+}
+
+static void sig_message_action(Server *server, const char *msg,
+			       const char *nick, const char *address,
+			       const char *target)
+{
+	message_start(server, message_target(server, target, nick), nick,
+		      MSGLEVEL_ACTIONS);
+	/* don't mix up with the same text said normally */
+	message_set_key(msg, "*");
+}
+
+static void sig_message_notice(Server *server, const char *msg,
+			       const char *nick, const char *address,
+			       const char *target)
+{
+	message_start(server, message_target(server, target, nick), nick,
+		      MSGLEVEL_NOTICES);
+	message_set_key(msg, "");
+}
+
+static void sig_message_join(Server *server, const char *channel,
+			     const char *nick)
+{
+	message_start(server, channel, nick, MSGLEVEL_JOINS);
+}
+
+static void sig_message_part(Server *server, const char *channel,
+			     const char *nick, const char *address,
+			     const char *reason)
+{
+	message_start(server, channel, nick, MSGLEVEL_PARTS);
+	current->reason = g_strdup(reason);
+}
+
+static void sig_message_quit(Server *server, const char *nick,
+			     const char *address, const char *reason)
+{
+	/* printed to each channel the nick was in */
+	message_start(server, NULL, nick, MSGLEVEL_QUITS);
+	current->reason = g_strdup(reason);
+	current_once = FALSE;
+}
+
+static void sig_message_nick(Server *server, const char *newnick)
+{
+	message_start(server, NULL, newnick, MSGLEVEL_NICKS);
+	current_once = FALSE;
+}
+
+void gui_window_message_init(void)
+{
+	current = NULL;
+
+	signal_add_first("message public", (SIGNAL_FUNC) sig_message_public);
+	signal_add_first("message private", (SIGNAL_FUNC) sig_message_private);
+	signal_add_first("message irc action", (SIGNAL_FUNC) sig_message_action);
+	signal_add_first("message irc notice", (SIGNAL_FUNC) sig_message_notice);
+	signal_add_first("message join", (SIGNAL_FUNC) sig_message_join);
+	signal_add_first("message part", (SIGNAL_FUNC) sig_message_part);
+	signal_add_first("message quit", (SIGNAL_FUNC) sig_message_quit);
+	signal_add_first("message nick", (SIGNAL_FUNC) sig_message_nick);
+	signal_add_first("message own_nick", (SIGNAL_FUNC) sig_message_nick);
+	signal_add_last("message public", (SIGNAL_FUNC) message_clear);
+	signal_add_last("message private", (SIGNAL_FUNC) message_clear);
+	signal_add_last("message irc action", (SIGNAL_FUNC) message_clear);
+	signal_add_last("message irc notice", (SIGNAL_FUNC) message_clear);
+	signal_add_last("message join", (SIGNAL_FUNC) message_clear);
+	signal_add_last("message part", (SIGNAL_FUNC) message_clear);
+	signal_add_last("message quit", (SIGNAL_FUNC) message_clear);
+	signal_add_last("message nick", (SIGNAL_FUNC) message_clear);
+	signal_add_last("message own_nick", (SIGNAL_FUNC) message_clear);
+}
+
+void gui_window_message_deinit(void)
+{
+	message_clear();
+
+	signal_remove("message public", (SIGNAL_FUNC) sig_message_public);
+	signal_remove("message private", (SIGNAL_FUNC) sig_message_private);
+	signal_remove("message irc action", (SIGNAL_FUNC) sig_message_action);
+	signal_remove("message irc notice", (SIGNAL_FUNC) sig_message_notice);
+	signal_remove("message join", (SIGNAL_FUNC) sig_message_join);
+	signal_remove("message part", (SIGNAL_FUNC) sig_message_part);
+	signal_remove("message quit", (SIGNAL_FUNC) sig_message_quit);
+	signal_remove("message nick", (SIGNAL_FUNC) sig_message_nick);
+	signal_remove("message own_nick", (SIGNAL_FUNC) sig_message_nick);
+	signal_remove("message public", (SIGNAL_FUNC) message_clear);
+	signal_remove("message private", (SIGNAL_FUNC) message_clear);
+	signal_remove("message irc action", (SIGNAL_FUNC) message_clear);
+	signal_remove("message irc notice", (SIGNAL_FUNC) message_clear);
+	signal_remove("message join", (SIGNAL_FUNC) message_clear);
+	signal_remove("message part", (SIGNAL_FUNC) message_clear);
+	signal_remove("message quit", (SIGNAL_FUNC) message_clear);
+	signal_remove("message nick", (SIGNAL_FUNC) message_clear);
+	signal_remove("message own_nick", (SIGNAL_FUNC) message_clear);
+}
@@ -0,0 +1,26 @@
+#ifndef __GUI_WINDOW_MESSAGE_H
+#define __GUI_WINDOW_MESSAGE_H
+
+/* The message whose text is being printed right now. */
+typedef struct {
+	Server *server;
+	char *target; /* window item it's printed to */
+	char *nick;
+	char *reason; /* of parts and quits */
+	char *key; /* same for repeats of the same message, NULL if it
+		      isn't a text message */
+	int level; /* levels its lines are printed with */
+} GuiMessage;
+
+/* Returns the current message if dest is a line of it, otherwise NULL. */
+GuiMessage *gui_window_message_get(TEXT_DEST_REC *dest);
+/* A line was finished. If it was of the current message, the message
+   is forgotten so it can't be mixed up with later lines. Quits and
+   nick changes are printed to several windows and kept until the next
+   message. */
+void gui_window_message_finished(void);
+
+void gui_window_message_init(void);
+void gui_window_message_deinit(void);
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ gui-window-repeat.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "module.h"
+#include "signals.h"
+#include "settings.h"
+
+#include "gui-window.h"
+#include "gui-window-lines.h"
+#include "gui-window-repeat.h"
+
+typedef struct {
+	char *key; /* message of the last line, NULL if it wasn't one */
+	char *line_key; /* message of the line being printed */
+	time_t time; /* when the last line was first printed */
+	int count;
+
+	GtkTextMark *mark; /* end of the last line's own text */
+	unsigned int skip:1; /* dropping the current line */
+	unsigned int line_started:1; /* line_key is set */
+} WindowRepeat;
+
+static GHashTable *repeats; /* WindowGui => WindowRepeat */
+
+static WindowRepeat *repeat_get(WindowGui *window)
+{
+	WindowRepeat *rec;
+	GtkTextIter iter;
+
+	rec = g_hash_table_lookup(repeats, window);
+	if (rec == NULL) {
+		rec = g_new0(WindowRepeat, 1);
+		gtk_text_buffer_get_end_iter(window->buffer, &iter);
+		rec->mark = gtk_text_buffer_create_mark(window->buffer, NULL,
+							&iter, TRUE);
+		g_hash_table_insert(repeats, window, rec);
+	}
+	return rec;
+}
+
+int gui_window_repeat_skip(WindowGui *window, const char *key)
+{
+	WindowRepeat *rec;
+
+	if (!settings_get_bool("gui_collapse_repeats"))
+		return FALSE;
+
+	rec = repeat_get(window);
+	if (!rec->line_started) {
+		/* the job finishing the line has no message, so the key
+		   is taken from the line's first part */
+		g_free(rec->line_key);
+		rec->line_key = g_strdup(key);
+		rec->line_started = TRUE;
+	}
+
+	/* decided at the first part of the line */
+	if (!rec->skip && window->newline && key != NULL &&
+	    rec->key != NULL && strcmp(rec->key, key) == 0 &&
+	    time(NULL) - rec->time <= settings_get_int("gui_collapse_repeats_time"))
+		rec->skip = TRUE;
+
+	return rec->skip;
+}
+
+static void repeat_update_counter(WindowGui *window, WindowRepeat *rec)
+{
+	GtkTextIter start_iter, end_iter;
+	GtkTextTag *tag, *hidden_tag;
+	char *str;
+
+	tag = gtk_text_tag_table_lookup(window->tagtable, "repeat");
+	if (tag == NULL) {
+		tag = gtk_text_buffer_create_tag(window->buffer, "repeat",
+						 "foreground", "grey50", NULL);
+	}
+
+	/* the repeated line is still the last one, replace the counter
+	   after its text */
+	gtk_text_buffer_get_iter_at_mark(window->buffer, &start_iter,
+					 rec->mark);
+	gtk_text_buffer_get_end_iter(window->buffer, &end_iter);
+	gtk_text_buffer_delete(window->buffer, &start_iter, &end_iter);
+
+	/* filtered out with the line */
+	hidden_tag = gui_window_lines_last_hidden(window);
+
+	str = g_strdup_printf(" (repeated %d times)", rec->count);
+	gtk_text_buffer_insert_with_tags(window->buffer, &start_iter, str, -1,
+					 tag, hidden_tag, NULL);
+	g_free(str);
+}
+
+int gui_window_repeat_finished(WindowGui *window)
+{
+	WindowRepeat *rec;
+	GtkTextIter iter;
+
+	if (!settings_get_bool("gui_collapse_repeats")) {
+		rec = g_hash_table_lookup(repeats, window);
+		if (rec != NULL) {
+			g_free(rec->key);
+			g_free(rec->line_key);
+			rec->key = rec->line_key = NULL;
+			rec->skip = rec->line_started = FALSE;
+		}
+		return FALSE;
+	}
+
+	rec = repeat_get(window);
+	rec->line_started = FALSE;
+	if (rec->skip) {
+		rec->skip = FALSE;
+		rec->count++;
+		repeat_update_counter(window, rec);
+		return TRUE;
+	}
+
+	/* new line, remember it for comparing the next ones */
+	g_free(rec->key);
+	rec->key = rec->line_key;
+	rec->line_key = NULL;
+	rec->time = time(NULL);
+	rec->count = 1;
+
+	gtk_text_buffer_get_end_iter(window->buffer, &iter);
+	gtk_text_buffer_move_mark(window->buffer, rec->mark, &iter);
+	return FALSE;
+}
+
+static void sig_gui_window_destroyed(WindowGui *window)
+{
+	WindowRepeat *rec;
+
+	rec = g_hash_table_lookup(repeats, window);
+	if (rec == NULL)
+		return;
+
+	g_hash_table_remove(repeats, window);
+	g_free(rec->key);
+	g_free(rec->line_key);
+	g_free(rec);
+}
+
+void gui_window_repeat_init(void)
+{
+	repeats = g_hash_table_new((GHashFunc) g_direct_hash,
+				   (GCompareFunc) g_direct_equal);
+
+	settings_add_bool("lookandfeel", "gui_collapse_repeats", FALSE);
+	settings_add_int("lookandfeel", "gui_collapse_repeats_time", 60);
+
+	signal_add("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+}
+
+void gui_window_repeat_deinit(void)
+{
+	g_hash_table_destroy(repeats);
+
+	signal_remove("gui window destroyed", (SIGNAL_FUNC) sig_gui_window_destroyed);
+}
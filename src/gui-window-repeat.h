@@ -0,0 +1,19 @@
+#ifndef __GUI_WINDOW_REPEAT_H
+#define __GUI_WINDOW_REPEAT_H
+
+/* With gui_collapse_repeats, a message that is the same as the previous
+   line in the window (same server, target and nick) isn't printed,
+   instead a "(repeated N times)" counter is updated after the line. */
+
+/* key is the GuiMessage key of the line, passed along with the text as
+   it may be added to the window later. The key of the line's first part
+   is remembered for comparing the next lines. Returns TRUE if the text
+   being printed should be dropped. */
+int gui_window_repeat_skip(WindowGui *window, const char *key);
+/* Line was finished. Returns TRUE if it was dropped. */
+int gui_window_repeat_finished(WindowGui *window);
+
+void gui_window_repeat_init(void);
+void gui_window_repeat_deinit(void);
+
+#endif
@@ -0,0 +1,520 @@
+/*
+ gui-window-switcher.c : irssi
+
+    Copyright (C) 2002 Timo Sirainen
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "module.h"
+#include "signals.h"
+#include "misc.h"
+#include "servers.h"
+
+#include "gui-frame.h"
+#include "gui-window.h"
+#include "gui-window-switcher.h"
+#include "gui-windowlist.h"
+
+#include <gdk/gdkkeysyms.h>
+
+#define MAX_RESULTS 30
+
+extern char *window_get_label(Window *window);
+
+typedef struct {
+	Window *window;
+
+	char *label; /* shown in the result list */
+	char *text; /* casefolded label, name and server tag */
+	char refnum[MAX_INT_STRLEN];
+
+	unsigned int stamp; /* when the window was last active */
+} SwitcherEntry;
+
+typedef struct {
+	SwitcherEntry *entry;
+	int tier, score;
+} SwitcherMatch;
+
+typedef struct {
+	Frame *frame;
+
+	GtkWidget *window, *entry, *tree;
+	GtkListStore *store;
+} Switcher;
+
+enum {
+	MATCH_SUBSEQUENCE = 1,
+	MATCH_SUBSTRING,
+	MATCH_PREFIX,
+	MATCH_REFNUM
+};
+
+static GHashTable *entries;
+static unsigned int active_stamp;
+static Switcher *switcher;
+
+static void switcher_refresh(Switcher *switcher);
+
+static void entry_update(SwitcherEntry *entry)
+{
+	Window *window = entry->window;
+	Server *server;
+	GString *str;
+
+	g_free(entry->label);
+	g_free(entry->text);
+
+	server = window->active_server;
+	entry->label = window_get_label(window);
+
+	str = g_string_new(entry->label);
+	if (window->name != NULL && window->items != NULL)
+		g_string_sprintfa(str, " %s", window->name);
+	if (server != NULL)
+		g_string_sprintfa(str, " %s", server->tag);
+	else if (window->servertag != NULL)
+		g_string_sprintfa(str, " %s", window->servertag);
+
+	entry->text = g_utf8_casefold(str->str, -1);
+	g_string_free(str, TRUE);
+
+	ltoa(entry->refnum, window->refnum);
+
+	if (switcher != NULL)
+		switcher_refresh(switcher);
+}
+
+static void entry_destroy(SwitcherEntry *entry)
+{
+	g_free(entry->label);
+	g_free(entry->text);
+	g_free(entry);
+}
+
+static int is_word_start(const char *text, const char *pos)
+{
+	if (pos == text)
+		return TRUE;
+
+	switch (pos[-1]) {
+	case ' ':
+	case '#':
+	case '&':
+	case '.':
+	case '-':
+	case '_':
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/* Returns 0 if query doesn't match, otherwise the match tier.
+   score is set to how tightly the query matched. */
+static int entry_match(SwitcherEntry *entry, const char *query, int *score)
+{
+	const char *text, *pos, *last;
+
+	*score = 0;
+	if (*query == '\0')
+		return MATCH_SUBSEQUENCE;
+
+	if (strcmp(entry->refnum, query) == 0)
+		return MATCH_REFNUM;
+
+	text = entry->text;
+	pos = strstr(text, query);
+	if (pos != NULL) {
+		*score = is_word_start(text, pos) ? 10 : 0;
+		return pos == text ? MATCH_PREFIX : MATCH_SUBSTRING;
+	}
+
+	/* fuzzy: all query characters in order */
+	last = NULL;
+	for (pos = text; *query != '\0'; pos++, query++) {
+		pos = strchr(pos, *query);
+		if (pos == NULL)
+			return 0;
+
+		if (last != NULL && pos == last+1)
+			*score += 3;
+		if (is_word_start(text, pos))
+			*score += 5;
+		last = pos;
+	}
+	return MATCH_SUBSEQUENCE;
+}
+
+static gint match_compare(SwitcherMatch *m1, SwitcherMatch *m2)
+{
+	Window *w1, *w2;
+
+	if (m1->tier != m2->tier)
+		return m2->tier - m1->tier;
+
+	/* the more activity, the better */
+	w1 = m1->entry->window;
+	w2 = m2->entry->window;
+	if (w1->data_level != w2->data_level)
+		return w2->data_level - w1->data_level;
+
+	if (m1->score != m2->score)
+		return m2->score - m1->score;
+
+	/* most recently used first */
+	return m1->entry->stamp > m2->entry->stamp ? -1 :
+		m1->entry->stamp < m2->entry->stamp ? 1 : 0;
+}
+
+typedef struct {
+	const char *query;
+	GSList *matches;
+} MatchContext;
+
+static void entry_check_match(Window *window, SwitcherEntry *entry,
+			      MatchContext *ctx)
+{
+	SwitcherMatch *match;
+	int tier, score;
+
+	if (window == active_win)
+		return;
+
+	tier = entry_match(entry, ctx->query, &score);
+	if (tier == 0)
+		return;
+
+	match = g_new(SwitcherMatch, 1);
+	match->entry = entry;
+	match->tier = tier;
+	match->score = score;
+	ctx->matches = g_slist_prepend(ctx->matches, match);
+}
+
+static void switcher_refresh(Switcher *switcher)
+{
+	MatchContext ctx;
+	GtkTreeIter iter;
+	GtkTreePath *path;
+	GSList *tmp;
+	char *query, *label;
+	int count;
+
+	query = g_utf8_casefold(gtk_entry_get_text(GTK_ENTRY(switcher->entry)), -1);
+
+	ctx.query = query;
+	ctx.matches = NULL;
+	g_hash_table_foreach(entries, (GHFunc) entry_check_match, &ctx);
+	ctx.matches = g_slist_sort(ctx.matches, (GCompareFunc) match_compare);
+
+	gtk_list_store_clear(switcher->store);
+	count = 0;
+	for (tmp = ctx.matches; tmp != NULL; tmp = tmp->next) {
+		SwitcherMatch *match = tmp->data;
+		Window *window = match->entry->window;
+
+		if (count++ < MAX_RESULTS) {
+			label = g_strdup_printf("%d: %s", window->refnum,
+						match->entry->label);
+			gtk_list_store_append(switcher->store, &iter);
+			gtk_list_store_set(switcher->store, &iter,
+					   0, window, 1, label,
+					   2, data_level_get_color(window->data_level),
+					   -1);
+			g_free(label);
+		}
+		g_free(match);
+	}
+	g_slist_free(ctx.matches);
+	g_free(query);
+
+	if (count > 0) {
+		path = gtk_tree_path_new_first();
+		gtk_tree_view_set_cursor(GTK_TREE_VIEW(switcher->tree),
+					 path, NULL, FALSE);
+		gtk_tree_path_free(path);
+	}
+}
+
+static void switcher_activate(Switcher *switcher)
+{
+	GtkTreeSelection *sel;
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	Window *window;
+
+	sel = gtk_tree_view_get_selection(GTK_TREE_VIEW(switcher->tree));
+	if (!gtk_tree_selection_get_selected(sel, &model, &iter))
+		return;
+
+	gtk_tree_model_get(model, &iter, 0, &window, -1);
+	gtk_widget_destroy(switcher->window);
+
+	window_set_active(window);
+}
+
+static void switcher_move_cursor(Switcher *switcher, int diff)
+{
+	GtkTreePath *path;
+	int count, pos;
+
+	count = gtk_tree_model_iter_n_children(GTK_TREE_MODEL(switcher->store),
+					       NULL);
+	if (count == 0)
+		return;
+
+	gtk_tree_view_get_cursor(GTK_TREE_VIEW(switcher->tree), &path, NULL);
+	pos = path == NULL ? 0 : gtk_tree_path_get_indices(path)[0] + diff;
+	if (path != NULL)
+		gtk_tree_path_free(path);
+
+	pos = CLAMP(pos, 0, count-1);
+	path = gtk_tree_path_new_from_indices(pos, -1);
+	gtk_tree_view_set_cursor(GTK_TREE_VIEW(switcher->tree),
+				 path, NULL, FALSE);
+	gtk_tree_path_free(path);
+}
+
+static gboolean event_key_press(GtkWidget *widget, GdkEventKey *event,
+				Switcher *switcher)
+{
+	switch (event->keyval) {
+	case GDK_Escape:
+		gtk_widget_destroy(switcher->window);
+		return TRUE;
+	case GDK_Up:
+		switcher_move_cursor(switcher, -1);
+		return TRUE;
+	case GDK_Down:
+	case GDK_Tab:
+		switcher_move_cursor(switcher, 1);
+		return TRUE;
+	case GDK_Page_Up:
+		switcher_move_cursor(switcher, -10);
+		return TRUE;
+	case GDK_Page_Down:
+		switcher_move_cursor(switcher, 10);
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static void event_changed(GtkEditable *editable, Switcher *switcher)
+{
+	switcher_refresh(switcher);
+}
+
+static void event_activate(GtkEntry *entry, Switcher *switcher)
+{
+	switcher_activate(switcher);
+}
+
+static void event_row_activated(GtkTreeView *tree, GtkTreePath *path,
+				GtkTreeViewColumn *column, Switcher *switcher)
+{
+	switcher_activate(switcher);
+}
+
+static gboolean event_focus_out(GtkWidget *widget, GdkEventFocus *event,
+				Switcher *switcher)
+{
+	gtk_widget_destroy(switcher->window);
+	return FALSE;
+}
+
+static void event_destroy(GtkWidget *widget, Switcher *s)
+{
+	if (switcher == s)
+		switcher = NULL;
+	g_object_unref(G_OBJECT(s->store));
+	g_free(s);
+}
+
+void gui_window_switcher_open(Frame *frame)
+{
+	GtkWidget *window, *vbox, *sw;
+	GtkCellRenderer *renderer;
+	GtkTreeViewColumn *column;
+
+	if (switcher != NULL) {
+		gtk_window_present(GTK_WINDOW(switcher->window));
+		return;
+	}
+
+	switcher = g_new0(Switcher, 1);
+	switcher->frame = frame;
+	switcher->store = gtk_list_store_new(3, G_TYPE_POINTER,
+					     G_TYPE_STRING, G_TYPE_STRING);
+
+	switcher->window = window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+	gtk_window_set_decorated(GTK_WINDOW(window), FALSE);
+	gtk_window_set_transient_for(GTK_WINDOW(window), frame->window);
+	gtk_window_set_position(GTK_WINDOW(window),
+				GTK_WIN_POS_CENTER_ON_PARENT);
+	gtk_window_set_default_size(GTK_WINDOW(window), 400, 300);
+	g_signal_connect(G_OBJECT(window), "destroy",
+			 G_CALLBACK(event_destroy), switcher);
+	g_signal_connect(G_OBJECT(window), "focus-out-event",
+			 G_CALLBACK(event_focus_out), switcher);
+
+	vbox = gtk_vbox_new(FALSE, 3);
+	gtk_container_set_border_width(GTK_CONTAINER(vbox), 3);
+	gtk_container_add(GTK_CONTAINER(window), vbox);
+
+	/* search entry */
+	switcher->entry = gtk_entry_new();
+	g_signal_connect(G_OBJECT(switcher->entry), "key-press-event",
+			 G_CALLBACK(event_key_press), switcher);
+	g_signal_connect(G_OBJECT(switcher->entry), "changed",
+			 G_CALLBACK(event_changed), switcher);
+	g_signal_connect(G_OBJECT(switcher->entry), "activate",
+			 G_CALLBACK(event_activate), switcher);
+	gtk_box_pack_start(GTK_BOX(vbox), switcher->entry, FALSE, FALSE, 0);
+
+	/* results */
+	sw = gtk_scrolled_window_new(NULL, NULL);
+	gtk_scrolled_window_set_shadow_type(GTK_SCROLLED_WINDOW(sw),
+					    GTK_SHADOW_IN);
+	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(sw),
+				       GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+	gtk_box_pack_start(GTK_BOX(vbox), sw, TRUE, TRUE, 0);
+
+	switcher->tree = gtk_tree_view_new_with_model(GTK_TREE_MODEL(switcher->store));
+	gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(switcher->tree), FALSE);
+	gtk_tree_view_set_enable_search(GTK_TREE_VIEW(switcher->tree), FALSE);
+	g_signal_connect(G_OBJECT(switcher->tree), "row-activated",
+			 G_CALLBACK(event_row_activated), switcher);
+	gtk_container_add(GTK_CONTAINER(sw), switcher->tree);
+
+	renderer = gtk_cell_renderer_text_new();
+	column = gtk_tree_view_column_new_with_attributes(NULL, renderer,
+							  "text", 1,
+							  "foreground", 2,
+							  NULL);
+	gtk_tree_view_append_column(GTK_TREE_VIEW(switcher->tree), column);
+
+	switcher_refresh(switcher);
+
+	gtk_widget_show_all(window);
+	gtk_widget_grab_focus(switcher->entry);
+}
+
+static void sig_window_created(Window *window)
+{
+	SwitcherEntry *entry;
+
+	entry = g_new0(SwitcherEntry, 1);
+	entry->window = window;
+	entry->stamp = ++active_stamp;
+	g_hash_table_insert(entries, window, entry);
+
+	entry_update(entry);
+}
+
+static void sig_window_destroyed(Window *window)
+{
+	SwitcherEntry *entry;
+
+	entry = g_hash_table_lookup(entries, window);
+	if (entry == NULL)
+		return;
+
+	g_hash_table_remove(entries, window);
+	entry_destroy(entry);
+
+	if (switcher != NULL)
+		switcher_refresh(switcher);
+}
+
+static void sig_window_update(Window *window)
+{
+	SwitcherEntry *entry;
+
+	entry = g_hash_table_lookup(entries, window);
+	if (entry != NULL)
+		entry_update(entry);
+}
+
+static void sig_window_item_name_changed(WindowItem *item)
+{
+	Window *window;
+
+	window = window_item_window(item);
+	if (window != NULL)
+		sig_window_update(window);
+}
+
+static void sig_window_changed(Window *window)
+{
+	SwitcherEntry *entry;
+
+	if (window == NULL)
+		return;
+
+	entry = g_hash_table_lookup(entries, window);
+	if (entry != NULL)
+		entry->stamp = ++active_stamp;
+}
+
+void gui_window_switcher_init(void)
+{
+	GSList *tmp;
+
+	entries = g_hash_table_new((GHashFunc) g_direct_hash,
+				   (GCompareFunc) g_direct_equal);
+	active_stamp = 0;
+	switcher = NULL;
+
+	for (tmp = windows; tmp != NULL; tmp = tmp->next)
+		sig_window_created(tmp->data);
+
+	signal_add("window created", (SIGNAL_FUNC) sig_window_created);
+	signal_add("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_add("window name changed", (SIGNAL_FUNC) sig_window_update);
+	signal_add("window refnum changed", (SIGNAL_FUNC) sig_window_update);
+	signal_add("window server changed", (SIGNAL_FUNC) sig_window_update);
+	signal_add("window item new", (SIGNAL_FUNC) sig_window_update);
+	signal_add("window item remove", (SIGNAL_FUNC) sig_window_update);
+	signal_add("window item changed", (SIGNAL_FUNC) sig_window_update);
+	signal_add("window item name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_add("window changed", (SIGNAL_FUNC) sig_window_changed);
+}
+
+static int entry_free(Window *window, SwitcherEntry *entry)
+{
+	entry_destroy(entry);
+	return TRUE;
+}
+
+void gui_window_switcher_deinit(void)
+{
+	if (switcher != NULL)
+		gtk_widget_destroy(switcher->window);
+
+	g_hash_table_foreach_remove(entries, (GHRFunc) entry_free, NULL);
+	g_hash_table_destroy(entries);
+
+	signal_remove("window created", (SIGNAL_FUNC) sig_window_created);
+	signal_remove("window destroyed", (SIGNAL_FUNC) sig_window_destroyed);
+	signal_remove("window name changed", (SIGNAL_FUNC) sig_window_update);
+	signal_remove("window refnum changed", (SIGNAL_FUNC) sig_window_update);
+	signal_remove("window server changed", (SIGNAL_FUNC) sig_window_update);
+	signal_remove("window item new", (SIGNAL_FUNC) sig_window_update);
+	signal_remove("window item remove", (SIGNAL_FUNC) sig_window_update);
+	signal_remove("window item changed", (SIGNAL_FUNC) sig_window_update);
+	signal_remove("window item name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_remove("window changed", (SIGNAL_FUNC) sig_window_changed);
+}
@@ -0,0 +1,11 @@
+#ifndef __GUI_WINDOW_SWITCHER_H
+#define __GUI_WINDOW_SWITCHER_H
+
+/* popup a window list which can be searched by typing parts of
+   window names, channels, server tags or refnums */
+void gui_window_switcher_open(Frame *frame);
+
+void gui_window_switcher_init(void);
+void gui_window_switcher_deinit(void);
+
+#endif
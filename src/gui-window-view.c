@@ -21,11 +21,14 @@
 #include "module.h"
 #include "modules.h"
 #include "signals.h"
+#include "settings.h"
 
 #include "printtext.h"
 #include "window-items.h"
 
+#include "gui-burst.h"
 #include "gui-frame.h"
+#include "gui-scheduler.h"
 #include "gui-tab.h"
 #include "gui-window.h"
 #include "gui-window-view.h"
@@ -38,14 +41,39 @@ static void view_set_size(WindowView *view, GtkAllocation *alloc)
 	gui_window_update_width(view->window);
 }
 
+static void get_titles(WindowItem *item, GtkWidget *title, GSList **list)
+{
+	*list = g_slist_prepend(*list, title);
+}
+
+static void view_destroy_titles(WindowView *view)
+{
+	GSList *list, *tmp;
+
+	list = NULL;
+	g_hash_table_foreach(view->titles, (GHFunc) get_titles, &list);
+	for (tmp = list; tmp != NULL; tmp = tmp->next)
+		gtk_widget_destroy(tmp->data);
+	g_slist_free(list);
+}
+
 static gboolean event_destroy(GtkWidget *widget, WindowView *view)
 {
 	signal_emit("gui window view destroyed", 1, view);
+	gui_burst_cancel(view);
+	gui_scheduler_cancel(view);
+	if (view->resize_tag != -1)
+		g_source_remove(view->resize_tag);
 
-	g_signal_handler_disconnect(G_OBJECT(view->window->buffer),
-				    view->sig_changed);
+	gui_tab_remove_view(view->pane->tab, view);
+
+	if (view->realized) {
+		g_signal_handler_disconnect(G_OBJECT(view->window->buffer),
+					    view->sig_changed);
+	}
 	gui_window_remove_view(view);
-	gtk_widget_destroy(view->title);
+	view_destroy_titles(view);
+	g_hash_table_destroy(view->titles);
 
 	g_free(view);
 	return FALSE;
@@ -61,10 +89,11 @@ static gboolean event_button_press(GtkWidget *widget, GdkEventButton *event,
 	return event->button == 3;
 }
 
-static gboolean event_resize(GtkWidget *widget, GtkAllocation *alloc,
-			     WindowView *view)
+static gboolean resize_settled(WindowView *view)
 {
-	view_set_size(view, alloc);
+	view->resize_tag = -1;
+
+	view_set_size(view, &GTK_WIDGET(view->view)->allocation);
 	if (view->bottom) {
 		/* scroll position goes up when window is shrinked,
 		   make it go back down */
@@ -74,8 +103,53 @@ static gboolean event_resize(GtkWidget *widget, GtkAllocation *alloc,
 	return FALSE;
 }
 
+/* While the pane is being dragged we get a size_allocate for each
+   motion. GtkTextView itself re-wraps only the lines on screen right
+   away and the rest in its idle handler, so here only keep the view at
+   bottom cheaply and do the rest once the size stops changing. */
+static gboolean event_resize(GtkWidget *widget, GtkAllocation *alloc,
+			     WindowView *view)
+{
+	int settle, first;
+
+	if (alloc->width == view->alloc_width &&
+	    alloc->height == view->alloc_height)
+		return FALSE;
+
+	first = view->alloc_width == 0;
+	view->alloc_width = alloc->width;
+	view->alloc_height = alloc->height;
+
+	settle = settings_get_int("gui_resize_settle_time");
+	if (first || settle <= 0) {
+		/* the first size is needed right away for printing */
+		if (view->resize_tag != -1)
+			g_source_remove(view->resize_tag);
+		resize_settled(view);
+		return FALSE;
+	}
+
+	if (view->bottom) {
+		gtk_adjustment_set_value(view->adj, view->adj->upper -
+					 view->adj->page_size);
+	}
+
+	if (view->resize_tag != -1)
+		g_source_remove(view->resize_tag);
+	view->resize_tag = g_timeout_add(settle, (GSourceFunc) resize_settled,
+					 view);
+	return FALSE;
+}
+
 static gboolean event_changed(GtkWidget *widget, WindowView *view)
 {
+	view->prelaid = FALSE;
+
+	/* adjustment isn't reliable in the middle of resizing,
+	   keep the old bottom status */
+	if (view->resize_tag != -1)
+		return FALSE;
+
 	/* new text added - save bottom status */
 	view->bottom = view->adj->value+view->adj->step_increment >=
 		view->adj->upper - view->adj->page_size;
@@ -101,32 +175,62 @@ WindowView *gui_window_view_new(TabPane *pane, WindowGui *window,
 				GtkTextBuffer *buffer)
 {
         WindowView *view;
-	GtkWidget *sw, *text_view;
-	PangoFontDescription *font_desc;
-	GdkColor color;
 
 	view = g_new0(WindowView, 1);
 	view->window = window;
 	view->pane = pane;
+	view->bottom = TRUE;
+	view->resize_tag = -1;
+	view->titles = g_hash_table_new((GHashFunc) g_direct_hash,
+					(GCompareFunc) g_direct_equal);
+
+	/* placeholder for the text view */
+	view->widget = gtk_vbox_new(FALSE, 0);
+	g_signal_connect(G_OBJECT(view->widget), "destroy",
+			 G_CALLBACK(event_destroy), view);
+	g_signal_connect(G_OBJECT(pane->focus_widget), "button_press_event",
+			 G_CALLBACK(event_button_press), view);
+	gtk_widget_show(view->widget);
+
+	/* update pane */
+	pane->view = view;
+	gtk_box_pack_start(pane->box, view->widget, TRUE, TRUE, 0);
+	gui_tab_add_view(pane->tab, view);
+
+	gui_window_view_set_title(view);
+
+	signal_emit("gui window view created", 1, view);
+
+	if (pane->tab->realized)
+		gui_window_view_realize(view);
+	return view;
+}
+
+void gui_window_view_realize(WindowView *view)
+{
+	GtkWidget *sw, *text_view;
+	PangoFontDescription *font_desc;
+	GdkColor color;
 
-	view->sig_changed = g_signal_connect(G_OBJECT(buffer), "changed",
+	if (view->realized)
+		return;
+	view->realized = TRUE;
+
+	view->sig_changed = g_signal_connect(G_OBJECT(view->window->buffer),
+					     "changed",
 					     G_CALLBACK(event_changed), view);
 
 	/* scrolled window where to place text view */
-	view->widget = sw = gtk_scrolled_window_new(NULL, NULL);
-	g_signal_connect(G_OBJECT(sw), "destroy",
-			 G_CALLBACK(event_destroy), view);
+	sw = gtk_scrolled_window_new(NULL, NULL);
 	gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(sw),
 				       GTK_POLICY_AUTOMATIC,
 				       GTK_POLICY_ALWAYS);
 	view->adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(sw));
 
-	text_view = gtk_text_view_new_with_buffer(buffer);
+	text_view = gtk_text_view_new_with_buffer(view->window->buffer);
 	view->view = GTK_TEXT_VIEW(text_view);
 	g_signal_connect(G_OBJECT(text_view), "button_press_event",
 			 G_CALLBACK(event_button_press), view);
-	g_signal_connect(G_OBJECT(pane->focus_widget), "button_press_event",
-			 G_CALLBACK(event_button_press), view);
 	g_signal_connect_after(G_OBJECT(text_view), "size_allocate",
 			       G_CALLBACK(event_resize), view);
 	g_signal_connect(G_OBJECT(text_view), "motion_notify_event",
@@ -151,19 +255,19 @@ WindowView *gui_window_view_new(TabPane *pane, WindowGui *window,
 	gdk_color_parse("grey", &color);
 	gtk_widget_modify_text(text_view, GTK_STATE_NORMAL, &color);
 
-	gtk_widget_show_all(view->widget);
+	gtk_widget_show_all(sw);
+	gtk_box_pack_start(GTK_BOX(view->widget), sw, TRUE, TRUE, 0);
 
-	/* update pane */
-	pane->view = view;
-	gtk_box_pack_start(pane->box, view->widget, TRUE, TRUE, 0);
-
-	get_font_size(text_view, window->font_monospace,
+	get_font_size(text_view, view->window->font_monospace,
 		      &view->font_width, &view->font_height);
 
+	/* text printed while we were hidden */
+	gtk_text_view_scroll_mark_onscreen(view->view,
+		gtk_text_buffer_get_insert(view->window->buffer));
+
 	gui_window_view_set_title(view);
 
-	signal_emit("gui window view created", 1, view);
-	return view;
+	signal_emit("gui window view realized", 1, view);
 }
 
 char *window_get_label(Window *window)
@@ -193,59 +297,116 @@ char *window_get_label(Window *window)
 
 static void event_title_destroy(GtkWidget *widget, WindowView *view)
 {
-	view->title = NULL;
+	g_hash_table_remove(view->titles,
+			    g_object_get_data(G_OBJECT(widget), "title_item"));
+	if (view->title == widget)
+		view->title = NULL;
+}
+
+static GtkWidget *title_label_new(const char *text)
+{
+	GtkWidget *title;
+
+	title = gtk_label_new(text);
+	gtk_misc_set_alignment(GTK_MISC(title), 0, 0.5);
+	gtk_misc_set_padding(GTK_MISC(title), 10, 0);
+	g_object_set_data(G_OBJECT(title), "title_label", GINT_TO_POINTER(1));
+	return title;
+}
+
+/* titles are kept for each item in the window and only hidden when
+   another item becomes active */
+static GtkWidget *view_get_title(WindowView *view, WindowItem *item)
+{
+	WindowItemGui *witem_gui;
+	GtkWidget *title;
+
+	title = g_hash_table_lookup(view->titles, item);
+	if (title != NULL)
+		return title;
+
+	witem_gui = item == NULL ? NULL : MODULE_DATA(item);
+	title = witem_gui != NULL && witem_gui->get_title != NULL ?
+		witem_gui->get_title(view, item) : NULL;
+	if (title == NULL) {
+		title = title_label_new(item == NULL ?
+					view->window->window->name :
+					item->visible_name);
+	}
+
+	g_object_set_data(G_OBJECT(title), "title_item", item);
+	g_signal_connect(G_OBJECT(title), "destroy",
+			 G_CALLBACK(event_title_destroy), view);
+	g_hash_table_insert(view->titles, item, title);
+
+	gtk_box_pack_start(view->pane->titlebox, title, TRUE, TRUE, 0);
+	return title;
 }
 
 void gui_window_view_set_title(WindowView *view)
 {
 	Window *window;
+	WindowItemGui *witem_gui;
 	GtkWidget *title;
 	char *str;
 
+	if (gui_burst_defer((GuiBurstFunc) gui_window_view_set_title, view))
+		return;
+
 	str = window_get_label(view->window->window);
 	gtk_label_set_text(view->pane->label, str);
 	g_free(str);
 
-	if (view->pane->titlebox == NULL)
+	if (view->pane->tab->active_win == view->window->window)
+		gui_tab_update_label_text(view->pane->tab);
+
+	if (view->pane->titlebox == NULL || !view->realized)
 		return;
 
 	window = view->window->window;
-	if (window->active == NULL) {
-		/* empty window */
-		title = gtk_label_new(window->name);
-		gtk_misc_set_alignment(GTK_MISC(title), 0, 0.5);
-                gtk_misc_set_padding(GTK_MISC(title), 10, 0);
-		gui_tab_set_focus_colors(title, view->pane->focused);
-	} else {
-		/* window item */
-		WindowItemGui *witem_gui;
+	title = view_get_title(view, window->active);
 
+	if (g_object_get_data(G_OBJECT(title), "title_label") != NULL) {
+		/* name may have changed */
+		gtk_label_set_text(GTK_LABEL(title), window->active == NULL ?
+				   window->name : window->active->visible_name);
+		gui_tab_set_focus_colors(title, view->pane->focused);
+	} else if (title != view->title) {
 		witem_gui = MODULE_DATA(window->active);
-		title = witem_gui != NULL && witem_gui->get_title != NULL ?
-			witem_gui->get_title(view, window->active) : NULL;
-		if (title == NULL) {
-			title = gtk_label_new(window->active->visible_name);
-			gtk_misc_set_padding(GTK_MISC(title), 10, 0);
-			gtk_misc_set_alignment(GTK_MISC(title), 0, 0.5);
-			gui_tab_set_focus_colors(title, view->pane->focused);
-		}
+		if (witem_gui->update_title != NULL)
+			witem_gui->update_title(view, window->active, title);
 	}
 
+	if (title == view->title)
+		return;
+
 	if (view->title != NULL)
-		gtk_widget_destroy(view->title);
+		gtk_widget_hide(view->title);
 	view->title = title;
-
 	gtk_widget_show(title);
-	g_signal_connect(G_OBJECT(title), "destroy",
-			 G_CALLBACK(event_title_destroy), view);
+}
 
-	gtk_box_pack_start(view->pane->titlebox, title, TRUE, TRUE, 0);
+static void view_remove_title(WindowView *view, WindowItem *item)
+{
+	GtkWidget *title;
+
+	title = g_hash_table_lookup(view->titles, item);
+	if (title != NULL)
+		gtk_widget_destroy(title);
 }
 
 static void gui_window_views_set_title(Window *window)
 {
-	g_slist_foreach(WINDOW_GUI(window)->views,
-			(GFunc) gui_window_view_set_title, NULL);
+	GSList *tmp;
+
+	for (tmp = WINDOW_GUI(window)->views; tmp != NULL; tmp = tmp->next) {
+		WindowView *view = tmp->data;
+
+		gui_scheduler_add(view->pane->tab->visible ?
+				  GUI_JOB_VISIBLE : GUI_JOB_HIDDEN,
+				  (GuiJobFunc) gui_window_view_set_title,
+				  view);
+	}
 }
 
 static void sig_window_name_changed(Window *window)
@@ -259,14 +420,33 @@ static void sig_window_item_name_changed(WindowItem *item)
 	gui_window_views_set_title(window_item_window(item));
 }
 
+static void sig_window_item_new(Window *window, WindowItem *item)
+{
+	/* the label lists all the items */
+	gui_window_views_set_title(window);
+}
+
+static void sig_window_item_remove(Window *window, WindowItem *item)
+{
+	g_slist_foreach(WINDOW_GUI(window)->views,
+			(GFunc) view_remove_title, item);
+	gui_window_views_set_title(window);
+}
+
 void gui_window_views_init(void)
 {
+	settings_add_int("lookandfeel", "gui_resize_settle_time", 150);
+
 	signal_add("window name changed", (SIGNAL_FUNC) sig_window_name_changed);
 	signal_add("window item name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_add("window item new", (SIGNAL_FUNC) sig_window_item_new);
+	signal_add("window item remove", (SIGNAL_FUNC) sig_window_item_remove);
 }
 
 void gui_window_views_deinit(void)
 {
 	signal_remove("window name changed", (SIGNAL_FUNC) sig_window_name_changed);
 	signal_remove("window item name changed", (SIGNAL_FUNC) sig_window_item_name_changed);
+	signal_remove("window item new", (SIGNAL_FUNC) sig_window_item_new);
+	signal_remove("window item remove", (SIGNAL_FUNC) sig_window_item_remove);
 }
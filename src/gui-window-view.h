@@ -6,21 +6,30 @@ struct _WindowView {
 	WindowGui *window;
 
 	GtkWidget *widget, *title;
+	GHashTable *titles; /* WindowItem (NULL = empty window) => title */
 	GtkTextView *view;
 
 	GtkAdjustment *adj;
 
 	int font_width, font_height;
 	int approx_width, approx_height; /* as characters */
+	int data_level; /* counted in pane's tab */
 
+	int alloc_width, alloc_height; /* last seen text view size */
+	int resize_tag; /* waiting for resizing to settle */
 	gulong sig_changed;
 
+	unsigned int realized:1; /* text view and title have been built */
+	unsigned int prelaid:1; /* bottom laid out while hidden */
 	unsigned int bottom:1;
 	unsigned int cursor_link:1;
 };
 
+/* The view's widget is only a placeholder until the view is realized,
+   which happens when its tab is first shown. */
 WindowView *gui_window_view_new(TabPane *pane, WindowGui *window,
 				GtkTextBuffer *buffer);
+void gui_window_view_realize(WindowView *view);
 
 void gui_window_view_set_title(WindowView *view);
 
@@ -21,15 +21,29 @@
 #include "module.h"
 #include "signals.h"
 #include "settings.h"
+#include "servers.h"
+#include "channels.h"
+#include "levels.h"
 
 #include "printtext.h"
 
-#include "gui-colors.h"
+#include "gui-charset.h"
+#include "gui-context-expand.h"
 #include "gui-frame.h"
+#include "gui-print-worker.h"
+#include "gui-scheduler.h"
+#include "gui-style.h"
 #include "gui-tab.h"
 #include "gui-window.h"
 #include "gui-window-view.h"
 #include "gui-window-context.h"
+#include "gui-window-lines.h"
+#include "gui-window-message.h"
+#include "gui-window-repeat.h"
+#include "gui-window-switcher.h"
+
+/* enough for the context words of a normal line */
+#define LINE_ARENA_SIZE 1024
 
 void gui_window_activities_init(void);
 void gui_window_activities_deinit(void);
@@ -70,67 +84,83 @@ void gui_window_update_width(WindowGui *window)
 	for (tmp = window->views; tmp != NULL; tmp = tmp->next) {
 		WindowView *view = tmp->data;
 
+		if (!view->realized)
+			continue;
+
 		if (width == -1 || width > view->approx_width)
 			width = view->approx_width;
 		if (height == -1 || height > view->approx_height)
 			height = view->approx_height;
 	}
 
+	if (width == -1) {
+		/* no realized views, keep the old size */
+		return;
+	}
+
 	window->window->width = width;
 	window->window->height = height;
 }
 
-static int tab_has_window(Tab *tab, Window *window)
+int gui_window_is_visible(Window *window)
 {
-	GList *tmp;
-
-	for (tmp = tab->panes; tmp != NULL; tmp = tmp->next) {
-		TabPane *pane = tmp->data;
-
-		if (pane->view != NULL &&
-		    pane->view->window->window == window)
-			return TRUE;
-	}
-
-	return FALSE;
+	return WINDOW_GUI(window)->visible > 0;
 }
 
-int gui_window_is_visible(Window *window)
+static void line_cut_finish(WindowGui *window)
 {
-	GSList *tmp;
-
-	for (tmp = frames; tmp != NULL; tmp = tmp->next) {
-		Frame *frame = tmp->data;
+	gui_context_expand_add(window, window->line_cut->str);
+	g_string_free(window->line_cut, TRUE);
+	window->line_cut = NULL;
+}
 
-		if (tab_has_window(frame->active_tab, window))
-			return TRUE;
+/* Cut text so that the line won't get longer than gui_line_max_chars.
+   Wrapping and context word scanning are then bounded by it too. */
+static void line_cut_text(WindowGui *window, char *text)
+{
+	char *p;
+	long len;
+	int max;
+
+	max = settings_get_int("gui_line_max_chars");
+	if (max <= 0)
+		return;
+
+	len = g_utf8_strlen(text, -1);
+	if (window->line_chars + len > max) {
+		p = g_utf8_offset_to_pointer(text, max - window->line_chars);
+		window->line_cut = g_string_new(p);
+		*p = '\0';
+		len = max - window->line_chars;
 	}
-
-	return FALSE;
+	window->line_chars += len;
 }
 
-static void gui_window_print(WindowGui *window, TextDest *dest,
-			     const char *text, int fg, int bg, int flags)
+static void gui_window_print(WindowGui *window, PrintJob *job)
 {
 	GtkTextTag *tag;
 	GtkTextIter iter, start_iter;
-	GdkColor *colortab;
-	char *utf8_text, fg_tag_name[20], bg_tag_name[20];
-	int start_offset;
+	Server *server;
+	Channel *channel;
+	char *utf8_text;
+	int start_offset, flags;
+
+	if (gui_window_repeat_skip(window, job->repeat_key))
+		return;
 
 	memset(&iter, 0, sizeof(iter));
 	memset(&start_iter, 0, sizeof(start_iter));
 
-	utf8_text = g_locale_to_utf8(text, -1, NULL, NULL, NULL);
-	if (utf8_text == NULL) {
-		/* error - fallback to hardcoded charset (ms windows one) */
-		utf8_text = g_convert(text, strlen(text),
-				      "UTF-8", "CP1252",
-				      NULL, NULL, NULL);
-		if (utf8_text == NULL) {
-			/* shouldn't happen I think.. */
-			utf8_text = g_strdup(text);
+	utf8_text = job->text;
+	flags = job->flags;
+
+	if (window->line_cut != NULL) {
+		if ((flags & GUI_PRINT_FLAG_NEWLINE) == 0) {
+			/* rest of a cut line, save it for expanding */
+			g_string_append(window->line_cut, utf8_text);
+			return;
 		}
+		line_cut_finish(window);
 	}
 
 	gtk_text_buffer_get_end_iter(window->buffer, &iter);
@@ -138,10 +168,18 @@ static void gui_window_print(WindowGui *window, TextDest *dest,
 	if (window->newline) {
 		gtk_text_buffer_insert(window->buffer, &iter, "\n", 1);
 		window->newline = FALSE;
+		window->line_chars = 0;
 	}
 
-	if (flags & GUI_PRINT_FLAG_NEWLINE)
+	if (flags & GUI_PRINT_FLAG_NEWLINE) {
 		gtk_text_buffer_insert(window->buffer, &iter, "\n", 1);
+		window->line_chars = 0;
+	}
+
+	line_cut_text(window, utf8_text);
+	gui_window_lines_fragment(window, gtk_text_iter_get_line(&iter),
+				  job->time, job->level, job->nick,
+				  job->hilight);
 
 	if (flags & GUI_PRINT_FLAG_INDENT) {
 		/* get the current cursor position from
@@ -150,9 +188,16 @@ static void gui_window_print(WindowGui *window, TextDest *dest,
 		GtkTextView *view;
 
 		view = window->active_view->view;
-		gtk_text_view_get_iter_location(view, &iter, &location);
-		window->indent = -location.x +
-			gtk_text_view_get_left_margin(view);
+		if (view != NULL) {
+			gtk_text_view_get_iter_location(view, &iter,
+							&location);
+			window->indent = -location.x +
+				gtk_text_view_get_left_margin(view);
+		} else {
+			/* not shown yet, guess from the monospace width */
+			window->indent = -gtk_text_iter_get_line_offset(&iter) *
+				window->font_width;
+		}
 	}
 
 	/* add text */
@@ -172,81 +217,21 @@ static void gui_window_print(WindowGui *window, TextDest *dest,
 					  &start_iter, &iter);
 	}
 
-	if ((flags & GUI_PRINT_FLAG_MIRC_COLOR) == 0) {
-		/* normal color */
-		if (fg < 0 || fg > DEFAULT_COLORS)
-			fg = -1;
-		if (bg < 0 || bg > DEFAULT_COLORS)
-			bg = -1;
-		colortab = colors;
-
-		if (flags & GUI_PRINT_FLAG_BOLD) {
-			if (fg == -1)
-				fg = COLOR_BOLD;
-			else
-				fg |= 8;
-		}
-
-		if ((flags & GUI_PRINT_FLAG_BLINK) && bg != -1)
-			bg |= 8;
-
-		g_snprintf(fg_tag_name, sizeof(fg_tag_name), "c_%d", fg);
-		g_snprintf(bg_tag_name, sizeof(bg_tag_name), "bc_%d", bg);
-	} else {
-		/* mirc color */
-		fg %= MIRC_COLORS;
-		bg %= MIRC_COLORS;
-		colortab = mirc_colors;
-
-		g_snprintf(fg_tag_name, sizeof(fg_tag_name), "m_%d", fg);
-		g_snprintf(bg_tag_name, sizeof(bg_tag_name), "bm_%d", bg);
-	}
-
-	if ((flags & GUI_PRINT_FLAG_BOLD) &&
-	    (flags & GUI_PRINT_FLAG_MIRC_COLOR)) {
-		/* bold mirc color */
-		tag = gtk_text_tag_table_lookup(window->tagtable, "bold");
-		if (tag == NULL) {
-			tag = gtk_text_buffer_create_tag(window->buffer,
-							 "bold", NULL);
-			g_object_set(G_OBJECT(tag), "weight",
-				     PANGO_WEIGHT_BOLD, NULL);
-		}
-
+	/* colors and boldness */
+	tag = gui_style_get(window, gtk_text_iter_get_line(&start_iter),
+			    job->fg, job->bg, job->flags);
+	if (tag != NULL) {
 		gtk_text_buffer_apply_tag(window->buffer, tag,
 					  &start_iter, &iter);
 	}
 
-	if (fg >= 0) {
-		tag = gtk_text_tag_table_lookup(window->tagtable, fg_tag_name);
-		if (tag == NULL) {
-			tag = gtk_text_buffer_create_tag(window->buffer,
-							 fg_tag_name, NULL);
-			g_object_set(G_OBJECT(tag), "foreground-gdk",
-				     &colortab[fg], NULL);
-		}
-
-		gtk_text_buffer_apply_tag(window->buffer, tag,
-					  &start_iter, &iter);
-	}
-
-	if (bg >= 0) {
-		tag = gtk_text_tag_table_lookup(window->tagtable, bg_tag_name);
-		if (tag == NULL) {
-			tag = gtk_text_buffer_create_tag(window->buffer,
-							 bg_tag_name, NULL);
-			g_object_set(G_OBJECT(tag), "background-gdk",
-				     &colortab[fg], NULL);
-		}
-
-		gtk_text_buffer_apply_tag(window->buffer, tag,
-					  &start_iter, &iter);
-	}
-
-	/* add context tags */
-	gui_window_print_mark_context(window, dest, &start_iter, utf8_text);
-
-	g_free(utf8_text);
+	/* add context tags, the channel may have been left already */
+	server = job->server_tag == NULL ? NULL :
+		server_find_tag(job->server_tag);
+	channel = server == NULL || job->target == NULL ? NULL :
+		channel_find(server, job->target);
+	gui_window_print_mark_context(window, channel, &start_iter,
+				      utf8_text, job->words);
 }
 
 static void sig_window_create_override(gpointer tab)
@@ -279,23 +264,35 @@ static void sig_window_created(Window *window, void *automatic)
 	gui->window = window;
 	window->gui_data = gui;
 
-	gui->buffer = gtk_text_buffer_new(NULL);
+	gui->buffer = gtk_text_buffer_new(gui_style_tag_table());
 	gui->tagtable = gtk_text_buffer_get_tag_table(gui->buffer);
 	gui->font_monospace = pango_font_description_from_string("Monospace 10");
+	gui->font_width = 8;
+	gui->arena = gui_arena_new(LINE_ARENA_SIZE);
 
-	/* underline tag */
+	/* the tag table is shared, so these may exist already */
 	gui->tag_underline =
-		gtk_text_buffer_create_tag(gui->buffer, NULL, NULL);
-	g_object_set(G_OBJECT(gui->tag_underline), "underline",
-		     PANGO_UNDERLINE_SINGLE, NULL);
-	/* monospace tag */
+		gtk_text_tag_table_lookup(gui->tagtable, "underline");
+	if (gui->tag_underline == NULL) {
+		gui->tag_underline =
+			gtk_text_buffer_create_tag(gui->buffer, "underline",
+						   NULL);
+		g_object_set(G_OBJECT(gui->tag_underline), "underline",
+			     PANGO_UNDERLINE_SINGLE, NULL);
+	}
 	gui->tag_monospace =
-		gtk_text_buffer_create_tag(gui->buffer, NULL, NULL);
-	g_object_set(G_OBJECT(gui->tag_monospace), "font-desc",
-		     gui->font_monospace, NULL);
+		gtk_text_tag_table_lookup(gui->tagtable, "monospace");
+	if (gui->tag_monospace == NULL) {
+		gui->tag_monospace =
+			gtk_text_buffer_create_tag(gui->buffer, "monospace",
+						   NULL);
+		g_object_set(G_OBJECT(gui->tag_monospace), "font-desc",
+			     gui->font_monospace, NULL);
+	}
 
+	/* keep our own reference, views that aren't realized yet
+	   don't have a text view holding the buffer */
 	gui_window_add_view(gui, tab);
-	g_object_unref(G_OBJECT(gui->buffer));
 
 	/* just to make sure it won't contain invalid value before
 	   size_allocate event is sent to window view, which then
@@ -306,6 +303,11 @@ static void sig_window_created(Window *window, void *automatic)
 	signal_emit("gui window created", 1, gui);
 }
 
+static void sig_window_view_realized(WindowView *view)
+{
+	view->window->font_width = view->font_width;
+}
+
 static void sig_window_destroyed(Window *window)
 {
 	WindowGui *gui;
@@ -314,6 +316,7 @@ static void sig_window_destroyed(Window *window)
 	gui = WINDOW_GUI(window);
 
 	signal_emit("gui window destroyed", 1, gui);
+	gui_scheduler_cancel(gui);
 
 	while (gui->views != NULL) {
 		WindowView *view = gui->views->data;
@@ -330,7 +333,11 @@ static void sig_window_destroyed(Window *window)
 		}
 	}
 
+	if (gui->line_cut != NULL)
+		g_string_free(gui->line_cut, TRUE);
+	g_object_unref(G_OBJECT(gui->buffer));
 	pango_font_description_free(gui->font_monospace);
+	gui_arena_destroy(gui->arena);
 
 	g_free(gui);
 	window->gui_data = NULL;
@@ -357,19 +364,52 @@ static void sig_window_item_changed(Window *window, WindowItem *witem)
 	}
 }
 
+static PrintJob *print_job_new(Window *window, TextDest *dest)
+{
+	PrintJob *job;
+	GuiMessage *message;
+	const char *charset;
+
+	job = g_new0(PrintJob, 1);
+	job->window = WINDOW_GUI(window);
+	if (dest != NULL && dest->server != NULL && dest->target != NULL) {
+		job->server_tag = g_strdup(dest->server->tag);
+		job->target = g_strdup(dest->target);
+	}
+	message = gui_window_message_get(dest);
+	if (dest != NULL) {
+		job->time = time(NULL);
+		job->level = dest->level;
+		job->hilight = (dest->level & MSGLEVEL_HILIGHT) != 0 ||
+			dest->hilight_priority > 0;
+		job->nick = message == NULL ? NULL :
+			g_strdup(message->nick);
+	}
+	if (dest != NULL && dest->server != NULL) {
+		/* looked up here, the worker can't access the server */
+		charset = gui_charset_find(dest->server, dest->target);
+		job->charset = charset == NULL ? NULL : g_strdup(charset);
+	}
+
+	if (message != NULL && message->key != NULL)
+		job->repeat_key = g_strdup(message->key);
+	return job;
+}
+
 static void sig_gui_print_text(Window *window, void *fgcolor,
 			       void *bgcolor, void *pflags,
 			       const char *str, TEXT_DEST_REC *dest)
 {
-	int fg, bg, flags;
+	PrintJob *job;
 
 	g_return_if_fail(window != NULL);
 
-	flags = GPOINTER_TO_INT(pflags);
-	fg = GPOINTER_TO_INT(fgcolor);
-	bg = GPOINTER_TO_INT(bgcolor);
-
-	gui_window_print(WINDOW_GUI(window), dest, str, fg, bg, flags);
+	job = print_job_new(window, dest);
+	job->raw = g_strdup(str);
+	job->flags = GPOINTER_TO_INT(pflags);
+	job->fg = GPOINTER_TO_INT(fgcolor);
+	job->bg = GPOINTER_TO_INT(bgcolor);
+	gui_print_worker_add(job);
 }
 
 static GtkTextTag *get_indent_tag(WindowGui *gui, int indent)
@@ -386,13 +426,44 @@ static GtkTextTag *get_indent_tag(WindowGui *gui, int indent)
 	return tag;
 }
 
-static void sig_gui_printtext_finished(Window *window)
+static void window_trim_scrollback(WindowGui *gui)
+{
+	GtkTextIter start_iter, end_iter;
+	int lines, max_lines;
+
+        lines = gtk_text_buffer_get_line_count(gui->buffer);
+	max_lines = settings_get_int("scrollback_lines");
+	if (max_lines <= 0 || lines <= max_lines)
+		return;
+
+	/* remove first lines, there may be more of them than
+	   scrollback_burst_remove if we've been busy */
+	gui_context_expand_trim(gui, lines-max_lines);
+	gui_style_window_trim(gui, lines-max_lines);
+	gui_window_lines_trim(gui, lines-max_lines);
+	gtk_text_buffer_get_iter_at_line(gui->buffer, &start_iter, 0);
+	gtk_text_buffer_get_iter_at_line(gui->buffer, &end_iter,
+					 lines-max_lines);
+	gtk_text_buffer_delete(gui->buffer, &start_iter, &end_iter);
+}
+
+static void gui_window_print_finished(WindowGui *gui, PrintJob *job)
 {
-	WindowGui *gui;
 	GtkTextIter start_iter, end_iter;
 	int lines, max_lines, burst;
 
-	gui = WINDOW_GUI(window);
+	if (gui->line_cut != NULL)
+		line_cut_finish(gui);
+
+	/* nothing printed to the line needs the scratch strings anymore */
+	gui_arena_reset(gui->arena);
+
+	if (gui_window_repeat_finished(gui)) {
+		gui_window_lines_finished(gui, TRUE);
+		return;
+	}
+	gui_window_lines_finished(gui, FALSE);
+
 	if (gui->indent != 0) {
 		/* set indentation for line */
 		gtk_text_buffer_get_end_iter(gui->buffer, &end_iter);
@@ -410,19 +481,32 @@ static void sig_gui_printtext_finished(Window *window)
 	max_lines = settings_get_int("scrollback_lines");
 
 	if (max_lines > 0 && lines >= max_lines+burst) {
-		/* remove first lines */
-		gtk_text_buffer_get_iter_at_line(gui->buffer, &start_iter, 0);
-		gtk_text_buffer_get_iter_at_line(gui->buffer, &end_iter, burst);
-		gtk_text_buffer_delete(gui->buffer, &start_iter, &end_iter);
+		gui_scheduler_add(GUI_JOB_BACKGROUND,
+				  (GuiJobFunc) window_trim_scrollback, gui);
 	}
 
 	gui->newline = TRUE;
 }
 
+void gui_window_print_job(PrintJob *job)
+{
+	if (job->raw == NULL)
+		gui_window_print_finished(job->window, job);
+	else
+		gui_window_print(job->window, job);
+}
+
+static void sig_gui_printtext_finished(Window *window)
+{
+	gui_print_worker_add(print_job_new(window, NULL));
+	gui_window_message_finished();
+}
+
 void gui_windows_init(void)
 {
 	settings_add_int("history", "scrollback_lines", 500);
 	settings_add_int("history", "scrollback_burst_remove", 10);
+	settings_add_int("lookandfeel", "gui_line_max_chars", 4000);
 
 	window_create_override = -1;
 
@@ -433,17 +517,30 @@ void gui_windows_init(void)
 	signal_add("window item changed", (SIGNAL_FUNC) sig_window_item_changed);
 	signal_add("gui print text", (SIGNAL_FUNC) sig_gui_print_text);
 	signal_add("gui print text finished", (SIGNAL_FUNC) sig_gui_printtext_finished);
+	signal_add("gui window view realized", (SIGNAL_FUNC) sig_window_view_realized);
 
+	gui_styles_init();
 	gui_window_views_init();
 	gui_window_contexts_init();
+	gui_window_message_init();
+	gui_window_repeat_init();
+	gui_window_lines_init();
+	gui_print_workers_init();
         gui_window_activities_init();
+	gui_window_switcher_init();
 }
 
 void gui_windows_deinit(void)
 {
+	gui_window_switcher_deinit();
         gui_window_activities_deinit();
+	gui_print_workers_deinit();
+	gui_window_lines_deinit();
+	gui_window_repeat_deinit();
+	gui_window_message_deinit();
 	gui_window_contexts_deinit();
 	gui_window_views_deinit();
+	gui_styles_deinit();
 
 	signal_remove("gui window create override", (SIGNAL_FUNC) sig_window_create_override);
 	signal_remove("window created", (SIGNAL_FUNC) sig_window_created);
@@ -452,4 +549,5 @@ void gui_windows_deinit(void)
 	signal_remove("window item changed", (SIGNAL_FUNC) sig_window_item_changed);
 	signal_remove("gui print text", (SIGNAL_FUNC) sig_gui_print_text);
 	signal_remove("gui print text finished", (SIGNAL_FUNC) sig_gui_printtext_finished);
+	signal_remove("gui window view realized", (SIGNAL_FUNC) sig_window_view_realized);
 }
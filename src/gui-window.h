@@ -2,6 +2,7 @@
 #define __GUI_WINDOW_H
 
 #include "fe-windows.h"
+#include "gui-arena.h"
 
 #define WINDOW_GUI(window) ((WindowGui *) ((window)->gui_data))
 
@@ -15,11 +16,16 @@ struct _WindowGui {
 	GtkTextTag *tag_monospace;
 
 	PangoFontDescription *font_monospace;
+	int font_width; /* from the last realized view */
 	int indent;
+	int line_chars; /* characters printed to the last line */
+	GString *line_cut; /* text cut from the last line, NULL if none */
+	GuiArena *arena; /* reset after each line */
 	unsigned int newline:1;
 
 	GSList *views;
 	WindowView *active_view;
+	int visible; /* views in active tabs */
 
 	Window *window;
 };
@@ -24,17 +24,17 @@
 
 #include "printtext.h"
 
+#include "gui-burst.h"
 #include "gui-colors.h"
 #include "gui-frame.h"
+#include "gui-scheduler.h"
 #include "gui-tab.h"
 #include "gui-window.h"
 #include "gui-window-view.h"
 #include "gui-window-context.h"
 #include "gui-windowlist.h"
 
-extern char *window_get_label(Window *window);
-
-static const gchar *data_level_get_color(int data_level)
+const gchar *data_level_get_color(int data_level)
 {
         /* get the color */
         switch (data_level) {
@@ -59,15 +59,11 @@ static gint gui_windowlist_sort_func(GtkTreeModel *model,
 				     gpointer user_data)
 {
 	Tab *tab_a, *tab_b;
-	gint pos_a, pos_b;
 
 	gtk_tree_model_get(model, a, 0, &tab_a, -1);
 	gtk_tree_model_get(model, b, 0, &tab_b, -1);
 
-	pos_a = gtk_notebook_page_num(GTK_NOTEBOOK(tab_a->frame->notebook), tab_a->widget);
-	pos_b = gtk_notebook_page_num(GTK_NOTEBOOK(tab_b->frame->notebook), tab_b->widget);
-
-	return (pos_a - pos_b);
+	return tab_a->page - tab_b->page;
 }
 
 static void tab_id_set_func(GtkTreeViewColumn *column,
@@ -82,7 +78,7 @@ static void tab_id_set_func(GtkTreeViewColumn *column,
 
 	gtk_tree_model_get(model, iter, 0, &tab, -1);
 
-	g_snprintf(tabid, 20, "%d:", gtk_notebook_page_num(GTK_NOTEBOOK(tab->frame->notebook), tab->widget) + 1);
+	g_snprintf(tabid, 20, "%d:", tab->page + 1);
 
 	color = data_level_get_color(tab->data_level);
 
@@ -96,17 +92,14 @@ static void tab_name_set_func(GtkTreeViewColumn *column,
 			      gpointer           data)
 {
 	Tab *tab;
-	gchar *tabid;
 	const gchar *color = NULL;
 
 	gtk_tree_model_get(model, iter, 0, &tab, -1);
 
-	tabid = window_get_label(tab->active_win);
 	color = data_level_get_color(tab->data_level);
 
-	g_object_set(G_OBJECT(cell), "text", tabid, "foreground", color, NULL);
-
-	g_free(tabid);
+	g_object_set(G_OBJECT(cell), "text", tab->label_text,
+		     "foreground", color, NULL);
 }
 
 static gboolean gui_windowlist_notebook_page_switched(GtkNotebook *notebook,
@@ -159,6 +152,8 @@ WindowList *gui_windowlist_new(Frame *frame)
 	winlist = g_new0(WindowList, 1);
 
 	winlist->frame = frame;
+	winlist->rows = g_hash_table_new((GHashFunc) g_direct_hash,
+					 (GCompareFunc) g_direct_equal);
 	winlist->store = store = gtk_list_store_new(1, G_TYPE_POINTER);
 	gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(store), 0,
 					gui_windowlist_sort_func, NULL, NULL);
@@ -195,29 +190,100 @@ WindowList *gui_windowlist_new(Frame *frame)
 	return winlist;
 }
 
+static void row_add(WindowList *winlist, Tab *tab)
+{
+	GtkTreeIter *iter;
+
+	iter = g_new(GtkTreeIter, 1);
+	gtk_list_store_append(winlist->store, iter);
+	gtk_list_store_set(winlist->store, iter, 0, tab, -1);
+	g_hash_table_insert(winlist->rows, tab, iter);
+}
+
+static void tab_row_changed(Tab *tab)
+{
+	WindowList *winlist = tab->frame->winlist;
+	GtkTreeIter *iter;
+	GtkTreePath *path;
+
+	iter = g_hash_table_lookup(winlist->rows, tab);
+	if (iter == NULL)
+		return;
+
+	path = gtk_tree_model_get_path(GTK_TREE_MODEL(winlist->store), iter);
+	gtk_tree_model_row_changed(GTK_TREE_MODEL(winlist->store), path, iter);
+	gtk_tree_path_free(path);
+}
+
+static void windowlist_add_pending(Frame *frame)
+{
+	WindowList *winlist = frame->winlist;
+	GtkTreeView *tv = GTK_TREE_VIEW(winlist->treeview);
+	GSList *tmp;
+	int page;
+
+	/* detach the view while adding so it's updated only once */
+	gtk_tree_view_set_model(tv, NULL);
+
+	winlist->pending_tabs = g_slist_reverse(winlist->pending_tabs);
+	for (tmp = winlist->pending_tabs; tmp != NULL; tmp = tmp->next)
+		row_add(winlist, tmp->data);
+	g_slist_free(winlist->pending_tabs);
+	winlist->pending_tabs = NULL;
+
+	gtk_tree_view_set_model(tv, GTK_TREE_MODEL(winlist->store));
+
+	page = gtk_notebook_get_current_page(frame->notebook);
+	if (page >= 0) {
+		gui_windowlist_notebook_page_switched(frame->notebook, NULL,
+						      page, frame);
+	}
+}
+
 static void gui_windowlist_new_tab(Tab *tab)
 {
-	GtkTreeIter iter;
+	WindowList *winlist = tab->frame->winlist;
 
-	gtk_list_store_append(tab->frame->winlist->store, &iter);	
-	gtk_list_store_set(tab->frame->winlist->store, &iter, 0, tab, -1);
+	if (gui_burst_defer((GuiBurstFunc) windowlist_add_pending,
+			    tab->frame)) {
+		winlist->pending_tabs =
+			g_slist_prepend(winlist->pending_tabs, tab);
+		return;
+	}
+
+	row_add(winlist, tab);
+}
+
+static void row_changed(WindowList *winlist, Tab *tab)
+{
+	gui_scheduler_add(GUI_JOB_VISIBLE, (GuiJobFunc) tab_row_changed, tab);
 }
 
 static void gui_windowlist_destroy_tab(Tab *tab)
 {
-	GtkTreeModel *model;
-	GtkTreeIter iter;
-	Tab *val_tab;
-
-	model = GTK_TREE_MODEL(tab->frame->winlist->store);
-	gtk_tree_model_get_iter_first(model, &iter);
-	do {
-		gtk_tree_model_get(model, &iter, 0, &val_tab, -1);
-		if (val_tab == tab) {
-			gtk_list_store_remove(tab->frame->winlist->store, &iter);
-			break;
-		}
-	} while (gtk_tree_model_iter_next(model, &iter));
+	WindowList *winlist = tab->frame->winlist;
+	GtkTreeIter *iter;
+
+	gui_scheduler_cancel(tab);
+
+	if (g_slist_find(winlist->pending_tabs, tab) != NULL) {
+		winlist->pending_tabs =
+			g_slist_remove(winlist->pending_tabs, tab);
+		return;
+	}
+
+	iter = g_hash_table_lookup(winlist->rows, tab);
+	if (iter == NULL)
+		return;
+
+	g_hash_table_remove(winlist->rows, tab);
+	gtk_list_store_remove(winlist->store, iter);
+	g_free(iter);
+}
+
+static void sig_tab_label_changed(Tab *tab)
+{
+	row_changed(tab->frame->winlist, tab);
 }
 
 static void gui_windowlist_update_window_activity(Window *window)
@@ -242,13 +308,14 @@ static void gui_windowlist_update_window_activity(Window *window)
 	tab = pane->tab;
 	g_return_if_fail(tab != NULL);
 
-	gtk_widget_queue_draw(tab->frame->winlist->treeview);
+	row_changed(tab->frame->winlist, tab);
 }
 
 void gui_windowlist_init(void)
 {
 	signal_add("gui tab created", (SIGNAL_FUNC) gui_windowlist_new_tab);
 	signal_add("gui tab destroyed", (SIGNAL_FUNC) gui_windowlist_destroy_tab);
+	signal_add("gui tab label changed", (SIGNAL_FUNC) sig_tab_label_changed);
 
 	signal_add("window hilight", (SIGNAL_FUNC) gui_windowlist_update_window_activity);
 	signal_add("window changed", (SIGNAL_FUNC) gui_windowlist_update_window_activity);
@@ -258,6 +325,7 @@ void gui_windowlist_deinit(void)
 {
 	signal_remove("gui tab created", (SIGNAL_FUNC) gui_windowlist_new_tab);
 	signal_remove("gui tab destroyed", (SIGNAL_FUNC) gui_windowlist_destroy_tab);
+	signal_remove("gui tab label changed", (SIGNAL_FUNC) sig_tab_label_changed);
 
 	signal_remove("window hilight", (SIGNAL_FUNC) gui_windowlist_update_window_activity);
 	signal_remove("window changed", (SIGNAL_FUNC) gui_windowlist_update_window_activity);
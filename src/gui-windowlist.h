@@ -7,12 +7,19 @@ typedef struct {
 	GtkListStore *store;
 	Frame *frame;
 	gint changed_sig;
+
+	GHashTable *rows; /* Tab => GtkTreeIter in store */
+
+	GSList *pending_tabs; /* created during burst, not in store yet */
 } WindowList;
 
 #include "gui-frame.h"
 
 WindowList *gui_windowlist_new(Frame *frame);
 
+/* returns the color used for showing activity of data_level */
+const gchar *data_level_get_color(int data_level);
+
 void gui_windowlist_init(void);
 void gui_windowlist_deinit(void);
 
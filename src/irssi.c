@@ -30,11 +30,23 @@
 #include "printtext.h"
 #include "fe-common-core.h"
 
+#include "gui-arena.h"
+#include "gui-backpressure.h"
+#include "gui-burst.h"
 #include "gui-channel.h"
+#include "gui-charset.h"
+#include "gui-completion.h"
+#include "gui-context-expand.h"
+#include "gui-history-search.h"
 #include "gui-itemlist.h"
 #include "gui-keyboard.h"
+#include "gui-nick-colors.h"
 #include "gui-nicklist.h"
 #include "gui-nicklist-view.h"
+#include "gui-paste.h"
+#include "gui-prelayout.h"
+#include "gui-scan.h"
+#include "gui-scheduler.h"
 #include "gui-window.h"
 #include "gui-windowlist.h"
 #include "gui-tab.h"
@@ -65,6 +77,9 @@ void gui_context_nick_deinit(void);
 void gui_context_url_init(void);
 void gui_context_url_deinit(void);
 
+void gui_commands_init(void);
+void gui_commands_deinit(void);
+
 static void sig_exit(void)
 {
 	gtk_main_quit();
@@ -105,16 +120,29 @@ static void gui_finish_init(void)
 #endif
         add_pixmap_directory(DATADIR "/images");
 
+	gui_commands_init();
+	gui_scan_init();
+	gui_arenas_init();
+	gui_charsets_init();
+	gui_scheduler_init();
+	gui_bursts_init();
+	gui_backpressure_init();
 	gui_windowlist_init();
 	gui_tabs_init();
 	gui_windows_init();
 	gui_itemlists_init();
 	gui_keyboards_init();
+	gui_pastes_init();
+	gui_prelayout_init();
+	gui_completions_init();
+	gui_history_search_init();
 	gui_nicklists_init();
 	gui_nicklist_views_init();
 	gui_channels_init();
         gui_context_nick_init();
+	gui_nick_colors_init();
         gui_context_url_init();
+	gui_context_expand_init();
 	gui_urls_init();
 
 	fe_common_core_finish_init();
@@ -145,16 +173,29 @@ static void gui_deinit(void)
         setup_preferences_destroy();
 
 	gui_urls_deinit();
+	gui_context_expand_deinit();
         gui_context_url_deinit();
+	gui_nick_colors_deinit();
         gui_context_nick_deinit();
 	gui_channels_deinit();
 	gui_nicklist_views_deinit();
 	gui_nicklists_deinit();
+	gui_history_search_deinit();
+	gui_completions_deinit();
+	gui_prelayout_deinit();
+	gui_pastes_deinit();
 	gui_keyboards_deinit();
 	gui_itemlists_deinit();
 	gui_windows_deinit();
 	gui_tabs_deinit();
 	gui_windowlist_deinit();
+	gui_backpressure_deinit();
+	gui_bursts_deinit();
+	gui_scheduler_deinit();
+	gui_charsets_deinit();
+	gui_arenas_deinit();
+	gui_scan_deinit();
+	gui_commands_deinit();
 
 	fe_common_irc_deinit();
 	fe_common_core_deinit();
@@ -164,6 +205,10 @@ static void gui_deinit(void)
 
 int main(int argc, char **argv)
 {
+	/* before any other glib calls, printing uses worker threads */
+	if (!g_thread_supported())
+		g_thread_init(NULL);
+
 	core_register_options();
 	fe_common_core_register_options();
 